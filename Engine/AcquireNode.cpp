@@ -5,6 +5,7 @@ using namespace VoxelEngine;
 AcquireNode::AcquireNode(VoxelEngine::Engine& engine, RenderGraph& graph)
     : RenderGraph::Node(graph, *engine.getGraphics().graphicsQueue(), vk::PipelineStageFlags::TopOfPipe)
 {
+    setName("AcquireNode");
     m_swapchain = &engine.getGraphics().swapchain();
 
     vk::SemaphoreCreateInfo info = {};
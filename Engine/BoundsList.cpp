@@ -0,0 +1,187 @@
+#include "Engine/BoundsList.h"
+
+#if defined(VOXEL_ENABLE_AVX2)
+#include <immintrin.h>
+#define VOXEL_SSE
+#elif defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VOXEL_SSE
+#endif
+
+using namespace VoxelEngine;
+
+void BoundsList::set(uint32_t id, glm::vec3 origin, glm::vec3 extent) {
+    glm::vec3 max = origin + extent;
+    auto it = m_indices.find(id);
+    size_t index;
+
+    if (it != m_indices.end()) {
+        index = it->second;
+    } else {
+        index = m_ids.size();
+        m_indices.insert({ id, index });
+        m_ids.push_back(id);
+        m_minX.push_back(0);
+        m_minY.push_back(0);
+        m_minZ.push_back(0);
+        m_maxX.push_back(0);
+        m_maxY.push_back(0);
+        m_maxZ.push_back(0);
+    }
+
+    m_minX[index] = origin.x;
+    m_minY[index] = origin.y;
+    m_minZ[index] = origin.z;
+    m_maxX[index] = max.x;
+    m_maxY[index] = max.y;
+    m_maxZ[index] = max.z;
+}
+
+void BoundsList::remove(uint32_t id) {
+    auto it = m_indices.find(id);
+    if (it == m_indices.end()) return;
+
+    //move the last box into the hole to keep the arrays packed
+    size_t index = it->second;
+    size_t last = m_ids.size() - 1;
+    m_indices.erase(it);
+
+    if (index != last) {
+        m_ids[index] = m_ids[last];
+        m_minX[index] = m_minX[last];
+        m_minY[index] = m_minY[last];
+        m_minZ[index] = m_minZ[last];
+        m_maxX[index] = m_maxX[last];
+        m_maxY[index] = m_maxY[last];
+        m_maxZ[index] = m_maxZ[last];
+        m_indices[m_ids[index]] = index;
+    }
+
+    m_ids.pop_back();
+    m_minX.pop_back();
+    m_minY.pop_back();
+    m_minZ.pop_back();
+    m_maxX.pop_back();
+    m_maxY.pop_back();
+    m_maxZ.pop_back();
+}
+
+void BoundsList::append(glm::vec3 origin, glm::vec3 extent) {
+    glm::vec3 max = origin + extent;
+
+    m_ids.push_back(static_cast<uint32_t>(m_ids.size()));
+    m_minX.push_back(origin.x);
+    m_minY.push_back(origin.y);
+    m_minZ.push_back(origin.z);
+    m_maxX.push_back(max.x);
+    m_maxY.push_back(max.y);
+    m_maxZ.push_back(max.z);
+}
+
+void BoundsList::clear() {
+    m_ids.clear();
+    m_indices.clear();
+    m_minX.clear();
+    m_minY.clear();
+    m_minZ.clear();
+    m_maxX.clear();
+    m_maxY.clear();
+    m_maxZ.clear();
+}
+
+void BoundsList::cull(const Frustum& frustum, std::vector<uint32_t>& visible) const {
+    size_t i = 0;
+
+#if defined(VOXEL_SSE)
+    const Plane* planes[6] = { &frustum.near, &frustum.far, &frustum.left, &frustum.right, &frustum.top, &frustum.bottom };
+
+    //the corner furthest along each plane's normal is the same for every box, so the component arrays can be chosen once per plane
+    const float* x[6];
+    const float* y[6];
+    const float* z[6];
+
+    for (size_t p = 0; p < 6; p++) {
+        glm::vec4 plane = planes[p]->components;
+        x[p] = plane.x >= 0 ? m_maxX.data() : m_minX.data();
+        y[p] = plane.y >= 0 ? m_maxY.data() : m_minY.data();
+        z[p] = plane.z >= 0 ? m_maxZ.data() : m_minZ.data();
+    }
+#endif
+
+#if defined(VOXEL_ENABLE_AVX2)
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (; i + 8 <= m_ids.size(); i += 8) {
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+        for (size_t p = 0; p < 6; p++) {
+            glm::vec4 plane = planes[p]->components;
+
+            __m256 distance = _mm256_set1_ps(plane.w);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.x), _mm256_loadu_ps(x[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.y), _mm256_loadu_ps(y[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.z), _mm256_loadu_ps(z[p] + i)));
+
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+        }
+
+        int32_t mask = _mm256_movemask_ps(inside);
+        if (mask == 0) continue;
+
+        for (size_t lane = 0; lane < 8; lane++) {
+            if ((mask & (1 << lane)) != 0) {
+                visible.push_back(m_ids[i + lane]);
+            }
+        }
+    }
+#endif
+
+#if defined(VOXEL_SSE)
+    for (; i + 4 <= m_ids.size(); i += 4) {
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+
+        for (size_t p = 0; p < 6; p++) {
+            glm::vec4 plane = planes[p]->components;
+
+            __m128 distance = _mm_set1_ps(plane.w);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.x), _mm_loadu_ps(x[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.y), _mm_loadu_ps(y[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.z), _mm_loadu_ps(z[p] + i)));
+
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+        }
+
+        int32_t mask = _mm_movemask_ps(inside);
+        if (mask == 0) continue;
+
+        for (size_t lane = 0; lane < 4; lane++) {
+            if ((mask & (1 << lane)) != 0) {
+                visible.push_back(m_ids[i + lane]);
+            }
+        }
+    }
+#endif
+
+    cullScalar(frustum, i, visible);
+}
+
+void BoundsList::cullScalar(const Frustum& frustum, size_t start, std::vector<uint32_t>& visible) const {
+    const Plane* planes[6] = { &frustum.near, &frustum.far, &frustum.left, &frustum.right, &frustum.top, &frustum.bottom };
+
+    for (size_t i = start; i < m_ids.size(); i++) {
+        bool inside = true;
+
+        for (size_t p = 0; p < 6 && inside; p++) {
+            glm::vec4 plane = planes[p]->components;
+            float x = plane.x >= 0 ? m_maxX[i] : m_minX[i];
+            float y = plane.y >= 0 ? m_maxY[i] : m_minY[i];
+            float z = plane.z >= 0 ? m_maxZ[i] : m_minZ[i];
+
+            inside = plane.x * x + plane.y * y + plane.z * z + plane.w >= 0;
+        }
+
+        if (inside) {
+            visible.push_back(m_ids[i]);
+        }
+    }
+}
\ No newline at end of file
@@ -43,6 +43,26 @@ bool Plane::testAABB(glm::vec3 origin, glm::vec3 extent) {
     return true;
 }
 
+bool Plane::containsAABB(glm::vec3 origin, glm::vec3 extent) {
+    glm::vec3 max = origin;
+
+    if (components.x < 0) {
+        max.x += extent.x;
+    }
+
+    if (components.y < 0) {
+        max.y += extent.y;
+    }
+
+    if (components.z < 0) {
+        max.z += extent.z;
+    }
+
+    if (distance(max) < 0) return false;
+
+    return true;
+}
+
 bool Frustum::testAABB(glm::vec3 origin, glm::vec3 extent) {
     return near.testAABB(origin, extent)
         && far.testAABB(origin, extent)
@@ -52,6 +72,15 @@ bool Frustum::testAABB(glm::vec3 origin, glm::vec3 extent) {
         && bottom.testAABB(origin, extent);
 }
 
+bool Frustum::containsAABB(glm::vec3 origin, glm::vec3 extent) {
+    return near.containsAABB(origin, extent)
+        && far.containsAABB(origin, extent)
+        && left.containsAABB(origin, extent)
+        && right.containsAABB(origin, extent)
+        && top.containsAABB(origin, extent)
+        && bottom.containsAABB(origin, extent);
+}
+
 Camera::Camera(Engine& engine, uint32_t width, uint32_t height, float fov, float nearPlane, float farPlane) {
     m_engine = &engine;
     m_width = width;
@@ -87,7 +116,9 @@ void Camera::setFarPlane(float value) {
 }
 
 void Camera::createProjectionMatrix() {
-    m_projectionMatrix = glm::perspectiveFovRH_ZO(m_fov, static_cast<float>(m_width), static_cast<float>(m_height), m_nearPlane, m_farPlane);
+    //reversed depth, the near plane maps to 1 and the far plane to 0
+    //together with a float depth buffer this keeps precision roughly constant over distance
+    m_projectionMatrix = glm::perspectiveFovRH_ZO(m_fov, static_cast<float>(m_width), static_cast<float>(m_height), m_farPlane, m_nearPlane);
     m_projectionMatrix[1][1] *= -1; //flip Y coordinate
 }
 
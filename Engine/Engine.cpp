@@ -1,6 +1,8 @@
 #include <Engine/Engine.h>
+#include <Engine/Utilities.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <stdexcept>
 
 using namespace VoxelEngine;
 
@@ -11,9 +13,19 @@ Engine::Engine() {
 
     glfwInit();
 
+    m_window = nullptr;
+    m_renderGraph = nullptr;
+    m_stop = false;
+    m_idle = false;
+    m_traceKey = Key::None;
+
     m_graphics = std::make_unique<Graphics>();
     m_updateClock = std::make_unique<Clock>(0.0f);
     m_updateGroup = std::make_unique<SystemGroup>(*m_updateClock);
+
+    //the main thread also runs tasks, so leave one core for it
+    uint32_t cores = std::thread::hardware_concurrency();
+    m_threadPool = std::make_unique<ThreadPool>(cores > 1 ? cores - 1 : 1);
 }
 
 Engine::~Engine() {
@@ -28,13 +40,85 @@ void Engine::setRenderGraph(RenderGraph& renderGraph) {
     m_renderGraph = &renderGraph;
 }
 
+void Engine::addWorkerThread(std::thread& thread) {
+    m_workerThreads.push_back(&thread);
+}
+
+void Engine::setTraceKey(Key key, const std::string& path) {
+    m_traceKey = key;
+    m_tracePath = path;
+}
+
+void Engine::setTargetFrameRate(float frameRate) {
+    m_framePacer.setFrameRate(frameRate);
+}
+
+void Engine::stop() {
+    m_stop = true;
+}
+
+void Engine::setIdle(bool idle) {
+    if (idle == m_idle) return;
+    m_idle = idle;
+
+    for (auto thread : m_workerThreads) {
+        setThreadPriority(*thread, idle ? ThreadPriority::Background : ThreadPriority::Normal);
+    }
+}
+
 void Engine::run() {
-    while (!m_window->shouldClose()) {
+    VOXEL_PROFILE_THREAD("Main");
+
+    while (!m_stop && !m_window->shouldClose()) {
+        //blocks on window events while minimized
         m_window->update();
 
-        if (!m_window->minimized()) {
+        bool minimized = m_window->minimized();
+        setIdle(minimized);
+
+        if (m_traceKey != Key::None && m_window->input().keyDown(m_traceKey)) {
+            writeTrace();
+        }
+
+        if (!minimized) {
+            VOXEL_PROFILE_SCOPE("Frame");
             m_updateClock->update();
             m_updateGroup->update();
+            m_framePacer.wait();
         }
     }
+
+    setIdle(false);
+}
+
+void Engine::writeTrace() {
+#ifdef VOXEL_ENABLE_PROFILER
+    if (Profiler::writeTrace(m_tracePath)) {
+        std::cout << "Wrote profiler trace to " << m_tracePath << std::endl;
+    } else {
+        std::cout << "Could not write profiler trace to " << m_tracePath << std::endl;
+    }
+#endif
+}
+
+void Engine::runHeadless(float tickRate) {
+    if (!(tickRate > 0)) throw std::runtime_error("Headless tick rate must be positive");
+
+    VOXEL_PROFILE_THREAD("Main");
+
+    //the window isn't polled and nothing is presented, the systems that render should be left out of the update group
+    //the main thread sleeps between ticks and leaves the cores to the workers
+    float frameRate = m_framePacer.frameRate();
+    m_framePacer.setFrameRate(tickRate);
+
+    float step = 1.0f / tickRate;
+
+    while (!m_stop) {
+        VOXEL_PROFILE_SCOPE("Tick");
+        m_updateClock->update(step);
+        m_updateGroup->update();
+        m_framePacer.wait();
+    }
+
+    m_framePacer.setFrameRate(frameRate);
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#include "Engine/FramePacer.h"
+#include <thread>
+
+using namespace VoxelEngine;
+
+constexpr std::chrono::microseconds FramePacer::spinThreshold;
+
+FramePacer::FramePacer() {
+    m_frameRate = 0;
+    m_period = Clock::duration::zero();
+    m_started = false;
+}
+
+void FramePacer::setFrameRate(float frameRate) {
+    m_frameRate = frameRate;
+    m_started = false;
+
+    if (frameRate > 0) {
+        m_period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / frameRate));
+    } else {
+        m_period = Clock::duration::zero();
+    }
+}
+
+void FramePacer::wait() {
+    if (m_period == Clock::duration::zero()) return;
+
+    Clock::time_point now = Clock::now();
+
+    if (!m_started) {
+        m_started = true;
+        m_next = now;
+    }
+
+    m_next += m_period;
+
+    //a frame that ran long moves the schedule instead of making the next frames rush to catch up
+    if (m_next < now) {
+        m_next = now;
+        return;
+    }
+
+    while (m_next - now > spinThreshold) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        now = Clock::now();
+    }
+
+    while (Clock::now() < m_next) {
+        std::this_thread::yield();
+    }
+}
\ No newline at end of file
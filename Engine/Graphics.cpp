@@ -4,6 +4,9 @@
 #include <unordered_set>
 #include <limits>
 #include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
 
 using namespace VoxelEngine;
 
@@ -11,6 +14,17 @@ const std::vector<std::string> deviceExtensions = {
     VK_KHR_SWAPCHAIN_EXTENSION_NAME
 };
 
+const std::string pipelineCachePath = "pipeline_cache.bin";
+
+//header that the driver writes at the start of the pipeline cache data (VK_PIPELINE_CACHE_HEADER_VERSION_ONE)
+struct PipelineCacheHeader {
+    uint32_t headerSize;
+    uint32_t headerVersion;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+};
+
 struct QueueIndices {
     uint32_t graphicsFamily = -1;
     uint32_t presentFamily = -1;
@@ -22,9 +36,16 @@ struct QueueIndices {
 };
 
 Graphics::Graphics() : m_onSwapchainChangedSignal(), m_onSwapchainChanged(m_onSwapchainChangedSignal) {
+    m_window = nullptr;
     createInstance();
 }
 
+Graphics::~Graphics() {
+    if (m_pipelineCache != nullptr) {
+        savePipelineCache();
+    }
+}
+
 void Graphics::createInstance() {
     vk::ApplicationInfo appInfo = {};
     appInfo.applicationName = "Voxel Game";
@@ -52,7 +73,7 @@ void Graphics::createInstance() {
     m_instance = std::make_unique<vk::Instance>(info);
 }
 
-QueueIndices getIndices(const vk::PhysicalDevice& physicalDevice, const vk::Surface& surface) {
+QueueIndices getIndices(const vk::PhysicalDevice& physicalDevice, const vk::Surface* surface) {
     QueueIndices indices;
 
     //search for dedicated transfer queue
@@ -75,10 +96,13 @@ QueueIndices getIndices(const vk::PhysicalDevice& physicalDevice, const vk::Surf
             indices.graphicsFamily = i;
         }
 
-        bool presentSupport = surface.supported(physicalDevice, i);
-
-        if (presentSupport) {
-            indices.presentFamily = i;
+        //without a surface nothing is presented, so the graphics queue stands in for the present queue
+        if (surface != nullptr) {
+            if (surface->supported(physicalDevice, i)) {
+                indices.presentFamily = i;
+            }
+        } else {
+            indices.presentFamily = indices.graphicsFamily;
         }
 
         //search for any transfer queue
@@ -102,17 +126,16 @@ QueueIndices getIndices(const vk::PhysicalDevice& physicalDevice, const vk::Surf
 
 void Graphics::setWindow(Window& window) {
     m_window = &window;
+    createSurface(window);
+}
 
+vk::PhysicalDeviceFeatures2 Graphics::getSupportedFeatures() {
     if (m_instance->physicalDevices().size() == 0) {
         throw std::runtime_error("Failed to find physical device with Vulkan support");
     }
 
-    createSurface(window);
-}
-
-vk::PhysicalDeviceFeatures2 Graphics::getSupportedFeatures() {
     for (auto& physicalDevice : m_instance->physicalDevices()) {
-        QueueIndices indices = getIndices(physicalDevice, *m_surface);
+        QueueIndices indices = getIndices(physicalDevice, m_surface.get());
 
         if (indices.valid()) {
             return physicalDevice.features();
@@ -122,8 +145,10 @@ vk::PhysicalDeviceFeatures2 Graphics::getSupportedFeatures() {
 }
 
 void Graphics::pickPhysicalDevice(vk::PhysicalDeviceFeatures2* requestedFeatures) {
+    m_enabledFeatures = *requestedFeatures;
+
     for (auto& physicalDevice : m_instance->physicalDevices()) {
-        QueueIndices indices = getIndices(physicalDevice, *m_surface);
+        QueueIndices indices = getIndices(physicalDevice, m_surface.get());
 
         if (indices.valid()) {
             createDevice(physicalDevice, requestedFeatures, indices.graphicsFamily, indices.presentFamily, indices.transferFamily);
@@ -131,9 +156,13 @@ void Graphics::pickPhysicalDevice(vk::PhysicalDeviceFeatures2* requestedFeatures
         }
     }
 
+    m_memory = std::make_unique<MemoryManager>(*m_device);
+
+    //a device created without a window has no swapchain
+    if (m_window == nullptr) return;
+
     createSwapchain();
     createImageViews();
-    m_memory = std::make_unique<MemoryManager>(*m_device);
 
     m_window->onFramebufferResized().connect<&Graphics::recreateSwapchain>(this);
 }
@@ -159,7 +188,10 @@ void Graphics::createDevice(const vk::PhysicalDevice& physicalDevice, vk::Physic
 
     vk::DeviceCreateInfo info = {};
     info.queueCreateInfos = std::move(queueInfos);
-    info.enabledExtensionNames = deviceExtensions;
+    if (m_window != nullptr) {
+        info.enabledExtensionNames = deviceExtensions;
+    }
+
     info.next = requestedFeatures;
 
     m_device = std::make_unique<vk::Device>(physicalDevice, info);
@@ -167,6 +199,65 @@ void Graphics::createDevice(const vk::PhysicalDevice& physicalDevice, vk::Physic
     m_graphicsQueue = &m_device->getQueue(graphicsIndex, 0);
     m_presentQueue = &m_device->getQueue(presentIndex, 0);
     m_transferQueue = &m_device->getQueue(transferIndex, 0);
+
+    createPipelineCache();
+}
+
+bool validPipelineCache(const std::vector<char>& data, const vk::PhysicalDevice& physicalDevice) {
+    if (data.size() < sizeof(PipelineCacheHeader)) return false;
+
+    PipelineCacheHeader header;
+    memcpy(&header, data.data(), sizeof(PipelineCacheHeader));
+
+    auto& properties = physicalDevice.properties();
+
+    //a cache from a different driver or device is rejected rather than handed to the driver
+    return header.headerSize >= sizeof(PipelineCacheHeader)
+        && header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+        && header.vendorID == properties.vendorID
+        && header.deviceID == properties.deviceID
+        && memcmp(header.pipelineCacheUUID, &properties.pipelineCacheUUID[0], VK_UUID_SIZE) == 0;
+}
+
+void Graphics::createPipelineCache() {
+    std::vector<char> data;
+    std::ifstream file(pipelineCachePath, std::ios::ate | std::ios::binary);
+
+    if (file.is_open()) {
+        data.resize(static_cast<size_t>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), data.size());
+
+        if (!file || !validPipelineCache(data, m_device->physicalDevice())) {
+            data.clear();
+        }
+    }
+
+    vk::PipelineCacheCreateInfo info = {};
+    info.initialDataSize = data.size();
+    info.initialData = data.data();
+
+    m_pipelineCache = std::make_unique<vk::PipelineCache>(*m_device, info);
+}
+
+void Graphics::savePipelineCache() {
+    auto data = m_pipelineCache->getData();
+
+    //write to a temporary file first so that a crash can't leave a truncated cache behind
+    std::string tempPath = pipelineCachePath + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return;
+
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+    file.close();
+
+    if (!file) {
+        std::remove(tempPath.c_str());
+        return;
+    }
+
+    std::remove(pipelineCachePath.c_str());
+    std::rename(tempPath.c_str(), pipelineCachePath.c_str());
 }
 
 vk::SurfaceFormat chooseSwapSurfaceFormat(const std::vector<vk::SurfaceFormat>& availableFormats) {
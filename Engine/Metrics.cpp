@@ -0,0 +1,176 @@
+#include "Engine/Metrics.h"
+#include <chrono>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <iomanip>
+
+using namespace VoxelEngine;
+
+namespace {
+    std::mutex s_mutex;
+    std::map<std::string, std::unique_ptr<Counter>> s_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> s_gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> s_histograms;
+
+    template <typename T>
+    T& getMetric(std::map<std::string, std::unique_ptr<T>>& map, const std::string& name) {
+        std::lock_guard<std::mutex> lock(s_mutex);
+        auto& ptr = map[name];
+
+        if (ptr == nullptr) {
+            ptr = std::make_unique<T>();
+        }
+
+        return *ptr;
+    }
+}
+
+Histogram::Histogram() {
+    for (auto& bucket : m_buckets) {
+        bucket = 0;
+    }
+
+    m_count = 0;
+    m_sum = 0;
+    m_max = 0;
+}
+
+uint32_t Histogram::getBucket(uint64_t value) {
+    if (value < subBucketCount) return static_cast<uint32_t>(value);
+
+    uint32_t msb = 0;
+    while ((value >> msb) > 1) msb++;
+
+    //the bits below the most significant bit select the linear bucket inside the power of two
+    uint32_t group = msb - subBucketBits + 1;
+    uint32_t sub = static_cast<uint32_t>(value >> (msb - subBucketBits)) & (subBucketCount - 1);
+    return group * subBucketCount + sub;
+}
+
+uint64_t Histogram::getValue(uint32_t bucket) {
+    uint32_t group = bucket / subBucketCount;
+    uint64_t sub = bucket % subBucketCount;
+    if (group == 0) return sub;
+
+    //upper bound of the bucket
+    uint32_t msb = group + subBucketBits - 1;
+    uint32_t shift = msb - subBucketBits;
+    uint64_t lower = (uint64_t(1) << msb) | (sub << shift);
+    return lower + (uint64_t(1) << shift) - 1;
+}
+
+void Histogram::record(uint64_t value) {
+    m_buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t max = m_max.load(std::memory_order_relaxed);
+    while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed));
+}
+
+double Histogram::mean() const {
+    uint64_t count = this->count();
+    if (count == 0) return 0;
+    return static_cast<double>(sum()) / count;
+}
+
+uint64_t Histogram::percentile(double percentile) const {
+    uint64_t count = this->count();
+    if (count == 0) return 0;
+
+    uint64_t target = static_cast<uint64_t>(percentile / 100.0 * count + 0.5);
+    if (target == 0) target = 1;
+
+    uint64_t total = 0;
+
+    for (uint32_t i = 0; i < bucketCount; i++) {
+        total += m_buckets[i].load(std::memory_order_relaxed);
+
+        if (total >= target) {
+            return std::min(getValue(i), max());
+        }
+    }
+
+    return max();
+}
+
+uint64_t Metrics::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+Counter& Metrics::counter(const std::string& name) {
+    return getMetric(s_counters, name);
+}
+
+Gauge& Metrics::gauge(const std::string& name) {
+    return getMetric(s_gauges, name);
+}
+
+Histogram& Metrics::histogram(const std::string& name) {
+    return getMetric(s_histograms, name);
+}
+
+void Metrics::writeText(std::ostream& stream) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (auto& pair : s_counters) {
+        stream << pair.first << ": " << pair.second->value() << "\n";
+    }
+
+    for (auto& pair : s_gauges) {
+        stream << pair.first << ": " << pair.second->value() << "\n";
+    }
+
+    for (auto& pair : s_histograms) {
+        auto& histogram = *pair.second;
+        stream << pair.first << ": count " << histogram.count()
+            << ", mean " << std::fixed << std::setprecision(1) << histogram.mean() << "us"
+            << ", p50 " << histogram.percentile(50) << "us"
+            << ", p90 " << histogram.percentile(90) << "us"
+            << ", p99 " << histogram.percentile(99) << "us"
+            << ", max " << histogram.max() << "us\n";
+    }
+}
+
+void Metrics::writeCsvHeader(std::ostream& stream) {
+    stream << "time,name,type,count,value,mean,p50,p90,p99,max\n";
+}
+
+void Metrics::writeCsv(std::ostream& stream, float time) {
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    for (auto& pair : s_counters) {
+        stream << time << "," << pair.first << ",counter,," << pair.second->value() << ",,,,,\n";
+    }
+
+    for (auto& pair : s_gauges) {
+        stream << time << "," << pair.first << ",gauge,," << pair.second->value() << ",,,,,\n";
+    }
+
+    for (auto& pair : s_histograms) {
+        auto& histogram = *pair.second;
+        stream << time << "," << pair.first << ",histogram," << histogram.count() << ",," << histogram.mean() << ","
+            << histogram.percentile(50) << "," << histogram.percentile(90) << "," << histogram.percentile(99) << "," << histogram.max() << "\n";
+    }
+
+    stream.flush();
+}
+
+MetricsWriter::MetricsWriter(const std::string& path, float interval) : m_stream(path) {
+    m_interval = interval;
+    m_timer = 0;
+    m_time = 0;
+
+    Metrics::writeCsvHeader(m_stream);
+}
+
+void MetricsWriter::update(Clock& clock) {
+    m_timer += clock.delta();
+    m_time += clock.delta();
+
+    if (m_timer >= m_interval) {
+        m_timer = 0;
+        Metrics::writeCsv(m_stream, m_time);
+    }
+}
\ No newline at end of file
@@ -4,6 +4,7 @@ using namespace VoxelEngine;
 
 PresentNode::PresentNode(VoxelEngine::Engine& engine, RenderGraph& graph, vk::PipelineStageFlags stage, AcquireNode& acquireNode)
     : RenderGraph::Node(graph, *engine.getGraphics().presentQueue(), stage) {
+    setName("PresentNode");
     m_presentQueue = engine.getGraphics().presentQueue();
     m_acquireNode = &acquireNode;
 
@@ -0,0 +1,157 @@
+#include "Engine/Profiler.h"
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+using namespace VoxelEngine;
+
+namespace {
+    //each slot carries a sequence number, odd while the owning thread is writing it and 2 * (index + 1) once the zone at index is complete
+    //writeTrace copies a slot and only keeps the copy if the sequence number was the expected one before and after
+    struct Slot {
+        std::atomic<uint64_t> sequence;
+        std::atomic<const char*> name;
+        std::atomic<uint64_t> start;
+        std::atomic<uint64_t> end;
+    };
+
+    //written only by the owning thread
+    struct ThreadBuffer {
+        uint32_t id;
+        std::string name;
+        std::unique_ptr<Slot[]> slots;
+        std::atomic<uint64_t> head;
+    };
+
+    std::atomic<bool> s_enabled(true);
+    std::mutex s_mutex;
+    std::vector<std::shared_ptr<ThreadBuffer>> s_threads;
+
+    ThreadBuffer& getThreadBuffer() {
+        //the list keeps buffers alive after their thread exits so the zones can still be written out
+        thread_local std::shared_ptr<ThreadBuffer> buffer;
+
+        if (buffer == nullptr) {
+            buffer = std::make_shared<ThreadBuffer>();
+            buffer->slots = std::make_unique<Slot[]>(Profiler::bufferSize);
+            buffer->head = 0;
+
+            for (size_t i = 0; i < Profiler::bufferSize; i++) {
+                buffer->slots[i].sequence = 0;
+            }
+
+            std::lock_guard<std::mutex> lock(s_mutex);
+            buffer->id = static_cast<uint32_t>(s_threads.size());
+            s_threads.push_back(buffer);
+        }
+
+        return *buffer;
+    }
+
+    //fails if the slot no longer holds the zone at index, or was overwritten while being copied
+    bool readSlot(const ThreadBuffer& buffer, uint64_t index, Profiler::Zone& zone) {
+        const Slot& slot = buffer.slots[index % Profiler::bufferSize];
+        uint64_t expected = (index + 1) * 2;
+
+        if (slot.sequence.load(std::memory_order_acquire) != expected) return false;
+
+        zone.name = slot.name.load(std::memory_order_relaxed);
+        zone.start = slot.start.load(std::memory_order_relaxed);
+        zone.end = slot.end.load(std::memory_order_relaxed);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.sequence.load(std::memory_order_relaxed) == expected;
+    }
+
+    void writeString(std::ofstream& stream, const char* string) {
+        stream << '"';
+
+        for (const char* c = string; *c != 0; c++) {
+            if (*c == '"' || *c == '\\') stream << '\\';
+            stream << *c;
+        }
+
+        stream << '"';
+    }
+}
+
+uint64_t Profiler::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+bool Profiler::enabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::setEnabled(bool enabled) {
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    std::lock_guard<std::mutex> lock(s_mutex);
+    buffer.name = name;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ThreadBuffer& buffer = getThreadBuffer();
+    uint64_t head = buffer.head.load(std::memory_order_relaxed);
+    Slot& slot = buffer.slots[head % bufferSize];
+
+    slot.sequence.store(head * 2 + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.start.store(start, std::memory_order_relaxed);
+    slot.end.store(end, std::memory_order_relaxed);
+
+    slot.sequence.store((head + 1) * 2, std::memory_order_release);
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+bool Profiler::writeTrace(const std::string& path) {
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open()) return false;
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+    bool first = true;
+
+    stream << "{\"traceEvents\":[\n";
+
+    for (auto& buffer : s_threads) {
+        if (buffer->name.size() > 0) {
+            if (!first) stream << ",\n";
+            first = false;
+
+            stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->id << ",\"args\":{\"name\":";
+            writeString(stream, buffer->name.c_str());
+            stream << "}}";
+        }
+
+        //zones the owning thread overwrites while this runs are dropped instead of written out torn
+        uint64_t head = buffer->head.load(std::memory_order_acquire);
+        uint64_t tail = head > bufferSize ? head - bufferSize : 0;
+
+        for (uint64_t i = tail; i < head; i++) {
+            Zone zone;
+            if (!readSlot(*buffer, i, zone)) continue;
+
+            if (!first) stream << ",\n";
+            first = false;
+
+            //timestamps are in microseconds
+            stream << "{\"name\":";
+            writeString(stream, zone.name);
+            stream << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->id;
+            stream << ",\"ts\":" << zone.start / 1000 << "." << zone.start % 1000 / 100;
+            stream << ",\"dur\":" << (zone.end - zone.start) / 1000 << "." << (zone.end - zone.start) % 1000 / 100 << "}";
+        }
+    }
+
+    stream << "\n]}\n";
+
+    return stream.good();
+}
\ No newline at end of file
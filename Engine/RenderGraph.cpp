@@ -1,5 +1,7 @@
 #include "Engine/RenderGraph/RenderGraph.h"
 #include "Engine/DirectedAcyclicGraph.h"
+#include "Engine/Profiler.h"
+#include <algorithm>
 
 using namespace VoxelEngine;
 
@@ -275,6 +277,55 @@ void RenderGraph::Node::createCommandBuffers() {
     m_submitInfo.next = &m_timelineSubmitInfo;
 }
 
+void RenderGraph::Node::createSecondaryCommandBuffers(uint32_t count) {
+    m_secondaryCommandBuffers.clear();
+    m_secondaryCommandPools.clear();
+
+    for (uint32_t i = 0; i < count; i++) {
+        vk::CommandPoolCreateInfo info = {};
+        info.queueFamilyIndex = m_queue->familyIndex();
+        info.flags = vk::CommandPoolCreateFlags::ResetCommandBuffer;
+
+        m_secondaryCommandPools.emplace_back(std::make_unique<vk::CommandPool>(m_queue->device(), info));
+
+        vk::CommandBufferAllocateInfo allocInfo = {};
+        allocInfo.commandPool = m_secondaryCommandPools.back().get();
+        allocInfo.commandBufferCount = m_graph->framesInFlight();
+        allocInfo.level = vk::CommandBufferLevel::Secondary;
+
+        m_secondaryCommandBuffers.emplace_back(m_secondaryCommandPools.back()->allocate(allocInfo));
+    }
+}
+
+vk::CommandBuffer& RenderGraph::Node::beginSecondaryCommandBuffer(uint32_t currentFrame, uint32_t index, vk::RenderPass& renderPass, uint32_t subpass, vk::Framebuffer& framebuffer) {
+    vk::CommandBuffer& commandBuffer = m_secondaryCommandBuffers[index][currentFrame];
+
+    commandBuffer.reset(vk::CommandBufferResetFlags::None);
+
+    vk::CommandBufferInheritanceInfo inheritanceInfo = {};
+    inheritanceInfo.renderPass = &renderPass;
+    inheritanceInfo.subpass = subpass;
+    inheritanceInfo.framebuffer = &framebuffer;
+
+    vk::CommandBufferBeginInfo info = {};
+    info.flags = vk::CommandBufferUsageFlags::OneTimeSubmit | vk::CommandBufferUsageFlags::RenderPassContinue;
+    info.inheritanceInfo = &inheritanceInfo;
+
+    commandBuffer.begin(info);
+
+    return commandBuffer;
+}
+
+void RenderGraph::Node::executeSecondaryCommandBuffers(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t count) {
+    m_secondaryExecutes.clear();
+
+    for (uint32_t i = 0; i < count; i++) {
+        m_secondaryExecutes.push_back(m_secondaryCommandBuffers[i][currentFrame]);
+    }
+
+    commandBuffer.executeCommands(m_secondaryExecutes);
+}
+
 void RenderGraph::Node::createSemaphore() {
     vk::SemaphoreTypeCreateInfo timelineInfo = {};
     timelineInfo.semaphoreType = vk::SemaphoreType::Timeline;
@@ -342,10 +393,23 @@ void RenderGraph::Node::internalRender(uint32_t currentFrame) {
 
     commandBuffer.begin(info);
 
+    bool timestamps = m_graph->timestampsEnabled() && m_timestampSupported;
+    vk::QueryPool* queryPool = nullptr;
+
+    if (timestamps) {
+        queryPool = m_graph->m_queryPools[currentFrame].get();
+        commandBuffer.resetQueryPool(*queryPool, m_timestampIndex, 2);
+        commandBuffer.writeTimestamp(vk::PipelineStageFlags::TopOfPipe, *queryPool, m_timestampIndex);
+    }
+
     makeInputTransfers(currentFrame, commandBuffer);
     render(currentFrame, commandBuffer);
     makeOutputTransfers(currentFrame, commandBuffer);
 
+    if (timestamps) {
+        commandBuffer.writeTimestamp(vk::PipelineStageFlags::BottomOfPipe, *queryPool, m_timestampIndex + 1);
+    }
+
     commandBuffer.end();
 }
 
@@ -363,6 +427,25 @@ void RenderGraph::Node::submit(uint32_t currentFrame) {
     m_queue->submit(m_submitInfo, nullptr);
 }
 
+void RenderGraph::Node::readTimestamp(const uint64_t* results, float timestampPeriod) {
+    uint64_t start = results[m_timestampIndex] & m_timestampMask;
+    uint64_t end = results[m_timestampIndex + 1] & m_timestampMask;
+    uint64_t ticks = (end - start) & m_timestampMask;   //handles the counter wrapping around
+    float time = static_cast<float>(ticks * static_cast<double>(timestampPeriod) / 1000000.0);
+
+    m_gpuTimes[m_gpuTimeIndex] = time;
+    m_gpuTimeIndex = (m_gpuTimeIndex + 1) % timestampHistory;
+    m_gpuTimeCount = std::min(m_gpuTimeCount + 1, timestampHistory);
+
+    float sum = 0;
+
+    for (size_t i = 0; i < m_gpuTimeCount; i++) {
+        sum += m_gpuTimes[i];
+    }
+
+    m_gpuTime = sum / m_gpuTimeCount;
+}
+
 RenderGraph::RenderGraph(vk::Device& device, uint32_t framesInFlight) {
     m_device = &device;
     m_framesInFlight = framesInFlight;
@@ -415,6 +498,10 @@ void RenderGraph::bake() {
     });
 
     makeSemaphores();
+
+    if (m_timestampsEnabled) {
+        createQueryPools();
+    }
 }
 
 void RenderGraph::makeSemaphores() {
@@ -436,6 +523,64 @@ void RenderGraph::makeSemaphores() {
     }
 }
 
+void RenderGraph::enableTimestamps() {
+    m_timestampsEnabled = true;
+
+    if (m_nodeList.size() > 0) {
+        createQueryPools();
+    }
+}
+
+void RenderGraph::createQueryPools() {
+    const vk::PhysicalDevice& physicalDevice = m_device->physicalDevice();
+    m_timestampPeriod = physicalDevice.properties().limits.timestampPeriod;
+
+    uint32_t queryCount = 0;
+
+    for (Node* node : m_nodeList) {
+        //some queues (usually dedicated transfer queues) can't write timestamps
+        //queries are reset in the node's own command buffer, which needs a graphics or compute queue, so transfer only queues are skipped too
+        auto& queueFamily = physicalDevice.queueFamilies()[node->queue().familyIndex()];
+        uint32_t validBits = queueFamily.timestampValidBits;
+        bool canReset = (queueFamily.queueFlags & (vk::QueueFlags::Graphics | vk::QueueFlags::Compute)) != vk::QueueFlags::None;
+        node->m_timestampSupported = validBits > 0 && canReset && m_timestampPeriod > 0;
+
+        if (!node->m_timestampSupported) continue;
+
+        node->m_timestampIndex = queryCount;
+        node->m_timestampMask = validBits >= 64 ? std::numeric_limits<uint64_t>::max() : (uint64_t(1) << validBits) - 1;
+        node->m_gpuTimes.resize(timestampHistory);
+        queryCount += 2;
+    }
+
+    m_queryPools.clear();
+    m_queryPoolsWritten.clear();
+    m_timestampResults.resize(queryCount);
+
+    if (queryCount == 0) return;
+
+    for (uint32_t i = 0; i < m_framesInFlight; i++) {
+        vk::QueryPoolCreateInfo info = {};
+        info.queryType = vk::QueryType::Timestamp;
+        info.queryCount = queryCount;
+
+        m_queryPools.emplace_back(std::make_unique<vk::QueryPool>(*m_device, info));
+        m_queryPoolsWritten.push_back(false);
+    }
+}
+
+void RenderGraph::readTimestamps(uint32_t currentFrame) {
+    if (m_queryPools.size() == 0 || !m_queryPoolsWritten[currentFrame]) return;
+
+    //only called after waiting on the frame that used this pool, so every query is available and this doesn't block
+    for (Node* node : m_nodeList) {
+        if (!node->m_timestampSupported) continue;
+
+        m_queryPools[currentFrame]->getResults(node->m_timestampIndex, 2, sizeof(uint64_t) * 2, &m_timestampResults[node->m_timestampIndex], sizeof(uint64_t), vk::QueryResultFlags::_64);
+        node->readTimestamp(m_timestampResults.data(), m_timestampPeriod);
+    }
+}
+
 void RenderGraph::wait() {
     wait(frameCount() - 2); //wait until previous frame finishes
 }
@@ -449,15 +594,24 @@ void RenderGraph::wait(uint32_t targetFrame) {
 }
 
 void RenderGraph::execute() {
+    VOXEL_PROFILE_SCOPE("RenderGraph::execute");
+
     for (auto node : m_nodeList) {
         node->clearSync(m_currentFrame);
     }
 
-    for (auto node : m_nodeList) {
-        node->preRender(m_currentFrame);
+    {
+        VOXEL_PROFILE_SCOPE("RenderGraph::preRender");
+        for (auto node : m_nodeList) {
+            node->preRender(m_currentFrame);
+        }
     }
 
-    wait(frameCount() - framesInFlight());
+    {
+        VOXEL_PROFILE_SCOPE("RenderGraph::wait");
+        wait(frameCount() - framesInFlight());
+        readTimestamps(m_currentFrame);
+    }
 
     m_bufferDestroyQueue.pop();
     m_bufferDestroyQueue.push({});
@@ -465,16 +619,29 @@ void RenderGraph::execute() {
     m_imageDestroyQueue.pop();
     m_imageDestroyQueue.push({});
 
-    for (auto node : m_nodeList) {
-        node->internalRender(m_currentFrame);
+    {
+        VOXEL_PROFILE_SCOPE("RenderGraph::record");
+        for (auto node : m_nodeList) {
+            node->internalRender(m_currentFrame);
+        }
     }
 
-    for (auto node : m_nodeList) {
-        node->submit(m_currentFrame);
+    {
+        VOXEL_PROFILE_SCOPE("RenderGraph::submit");
+        for (auto node : m_nodeList) {
+            node->submit(m_currentFrame);
+        }
     }
 
-    for (auto node : m_nodeList) {
-        node->postRender(m_currentFrame);
+    if (m_queryPools.size() > 0) {
+        m_queryPoolsWritten[m_currentFrame] = true;
+    }
+
+    {
+        VOXEL_PROFILE_SCOPE("RenderGraph::postRender");
+        for (auto node : m_nodeList) {
+            node->postRender(m_currentFrame);
+        }
     }
 
     m_frameCount++;
@@ -1,9 +1,11 @@
 #include <Engine/System.h>
+#include <Engine/Profiler.h>
 #include <algorithm>
 
 using namespace VoxelEngine;
 
 System::System() {
+    m_name = "System";
     m_group = nullptr;
 }
 
@@ -22,8 +24,9 @@ SystemGroup::SystemGroup(Clock& clock) {
     m_clock = &clock;
 }
 
-void SystemGroup::add(System& system, uint32_t priority) {
+void SystemGroup::add(System& system, uint32_t priority, const char* name) {
     system.setPriority(priority);
+    system.m_name = name;
     m_systems.push_back(&system);
     setDirty();
 }
@@ -40,6 +43,7 @@ void SystemGroup::update() {
     }
 
     for (auto system : m_systems) {
+        VOXEL_PROFILE_SCOPE(system->name());
         system->update(*m_clock);
     }
 }
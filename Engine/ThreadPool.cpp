@@ -0,0 +1,83 @@
+#include "Engine/ThreadPool.h"
+
+using namespace VoxelEngine;
+
+ThreadPool::ThreadPool(size_t threadCount) {
+    m_task = nullptr;
+    m_count = 0;
+    m_next = 0;
+    m_remaining = 0;
+    m_generation = 0;
+    m_stop = false;
+
+    for (size_t i = 0; i < threadCount; i++) {
+        m_threads.emplace_back([this] { loop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_stop = true;
+    lock.unlock();
+    m_condition.notify_all();
+
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::run(size_t count, const std::function<void(size_t)>& task) {
+    if (count == 0) return;
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_task = &task;
+    m_count = count;
+    m_next = 0;
+    m_remaining = count;
+    uint64_t generation = ++m_generation;
+    lock.unlock();
+    m_condition.notify_all();
+
+    while (runTask(generation));
+
+    lock.lock();
+    m_doneCondition.wait(lock, [this] { return m_remaining == 0; });
+    m_task = nullptr;
+}
+
+void ThreadPool::loop() {
+    uint64_t generation = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_condition.wait(lock, [&] { return m_stop || m_generation != generation; });
+            if (m_stop) return;
+            generation = m_generation;
+        }
+
+        while (runTask(generation));
+    }
+}
+
+bool ThreadPool::runTask(uint64_t generation) {
+    //tasks are claimed under the lock so that a worker that wakes up late can't pick up a task from the next call to run
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_generation != generation || m_next == m_count) return false;
+
+    size_t index = m_next++;
+    const std::function<void(size_t)>* task = m_task;
+    lock.unlock();
+
+    (*task)(index);
+
+    lock.lock();
+    m_remaining--;
+
+    if (m_remaining == 0) {
+        lock.unlock();
+        m_doneCondition.notify_all();
+    }
+
+    return true;
+}
\ No newline at end of file
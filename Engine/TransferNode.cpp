@@ -5,6 +5,7 @@ using namespace VoxelEngine;
 
 TransferNode::TransferNode(Engine& engine, RenderGraph& graph)
     : RenderGraph::Node(graph, *engine.getGraphics().transferQueue(), vk::PipelineStageFlags::TopOfPipe) {
+    setName("TransferNode");
     m_engine = &engine;
     m_renderGraph = &graph;
 
@@ -122,10 +123,11 @@ void TransferNode::transfer(Buffer& buffer, vk::DeviceSize size, vk::DeviceSize
 }
 
 void TransferNode::transfer(Image& image, vk::Offset3D offset, vk::Extent3D extent, vk::ImageSubresourceLayers subresourceLayers, const void* data) {
-    size_t size = extent.width * extent.height * extent.depth * vk::getFormatSize(image.image().format());
+    size_t size = getImageDataSize(image.image().format(), extent);
     if (size == 0) return;
     uint32_t currentFrame = m_renderGraph->currentFrame();
-    m_ptr = align(m_ptr, 4);
+    //the offset must be a multiple of the texel block size, which is at most 16
+    m_ptr = align(m_ptr, 16);
     char* ptr = static_cast<char*>(m_stagingBufferPtrs[currentFrame]) + m_ptr;
 
     memcpy(ptr, data, size);
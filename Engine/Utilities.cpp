@@ -1,5 +1,15 @@
 #include "Engine/Utilities.h"
 #include <fstream>
+#include <array>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 using namespace VoxelEngine;
 
@@ -31,9 +41,90 @@ std::vector<char> VoxelEngine::readFile(const std::string& filename) {
     return buffer;
 }
 
+size_t VoxelEngine::getImageDataSize(vk::Format format, vk::Extent3D extent) {
+    size_t blockSize = 0;
+
+    switch (format) {
+    case vk::Format::BC1_RGB_Unorm_Block:
+    case vk::Format::BC1_RGB_Srgb_Block:
+    case vk::Format::BC1_RGBA_Unorm_Block:
+    case vk::Format::BC1_RGBA_Srgb_Block:
+    case vk::Format::BC4_Unorm_Block:
+    case vk::Format::BC4_Snorm_Block:
+        blockSize = 8;
+        break;
+    case vk::Format::BC2_Unorm_Block:
+    case vk::Format::BC2_Srgb_Block:
+    case vk::Format::BC3_Unorm_Block:
+    case vk::Format::BC3_Srgb_Block:
+    case vk::Format::BC5_Unorm_Block:
+    case vk::Format::BC5_Snorm_Block:
+    case vk::Format::BC6H_Ufloat_Block:
+    case vk::Format::BC6H_Sfloat_Block:
+    case vk::Format::BC7_Unorm_Block:
+    case vk::Format::BC7_Srgb_Block:
+        blockSize = 16;
+        break;
+    default:
+        return extent.width * extent.height * extent.depth * vk::getFormatSize(format);
+    }
+
+    size_t blocksX = (extent.width + 3) / 4;
+    size_t blocksY = (extent.height + 3) / 4;
+    return blocksX * blocksY * extent.depth * blockSize;
+}
+
 vk::ShaderModule VoxelEngine::createShaderModule(vk::Device& device, const std::vector<char>& byteCode) {
     vk::ShaderModuleCreateInfo info = {};
     info.code = byteCode;
 
     return vk::ShaderModule(device, info);
+}
+
+void VoxelEngine::setThreadPriority(std::thread& thread, ThreadPriority priority) {
+#ifdef _WIN32
+    int value = priority == ThreadPriority::Background ? THREAD_PRIORITY_LOWEST : THREAD_PRIORITY_NORMAL;
+    SetThreadPriority(thread.native_handle(), value);
+#else
+    //SCHED_IDLE only runs the thread when nothing else wants the core, which doesn't need extra privileges
+    int policy = SCHED_OTHER;
+#ifdef SCHED_IDLE
+    if (priority == ThreadPriority::Background) {
+        policy = SCHED_IDLE;
+    }
+#endif
+
+    sched_param param = {};
+    param.sched_priority = 0;
+    pthread_setschedparam(thread.native_handle(), policy, &param);
+#endif
+}
+
+void VoxelEngine::radixSort(std::vector<uint64_t>& items, std::vector<uint64_t>& scratch) {
+    if (items.size() < 2) return;
+    scratch.resize(items.size());
+
+    for (uint32_t shift = 32; shift < 64; shift += 8) {
+        std::array<size_t, 256> counts = {};
+
+        for (auto item : items) {
+            counts[(item >> shift) & 0xFF]++;
+        }
+
+        //every item has the same digit, so this pass would not move anything
+        if (counts[(items[0] >> shift) & 0xFF] == items.size()) continue;
+
+        size_t offset = 0;
+        for (auto& count : counts) {
+            size_t temp = count;
+            count = offset;
+            offset += temp;
+        }
+
+        for (auto item : items) {
+            scratch[counts[(item >> shift) & 0xFF]++] = item;
+        }
+
+        items.swap(scratch);
+    }
 }
\ No newline at end of file
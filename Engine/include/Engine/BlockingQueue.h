@@ -2,6 +2,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <queue>
+#include <vector>
+#include <atomic>
+#include <algorithm>
 
 namespace VoxelEngine {
     template <typename T>
@@ -10,19 +13,47 @@ namespace VoxelEngine {
         BlockingQueue(size_t count) {
             m_maxCount = count;
             m_cancel = false;
+            m_size = 0;
         }
 
         bool tryEnqueue(T item) {
+            //a full queue is rejected without taking the lock
+            if (m_size.load(std::memory_order_acquire) >= m_maxCount) return false;
+
             std::unique_lock<std::mutex> lock(m_mutex);
             if (m_queue.size() == m_maxCount) return false;
 
             m_queue.push(item);
+            m_size.store(m_queue.size(), std::memory_order_release);
             lock.unlock();
             m_condition.notify_one();
 
             return true;
         }
 
+        //enqueues as many items as fit, in order, and returns how many were accepted
+        size_t tryEnqueueBulk(const T* items, size_t count) {
+            if (count == 0 || m_size.load(std::memory_order_acquire) >= m_maxCount) return 0;
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            size_t accepted = std::min(count, m_maxCount - m_queue.size());
+
+            for (size_t i = 0; i < accepted; i++) {
+                m_queue.push(items[i]);
+            }
+
+            m_size.store(m_queue.size(), std::memory_order_release);
+            lock.unlock();
+
+            if (accepted == 1) {
+                m_condition.notify_one();
+            } else if (accepted > 1) {
+                m_condition.notify_all();
+            }
+
+            return accepted;
+        }
+
         bool dequeue(T& result) {
             std::unique_lock<std::mutex> lock(m_mutex);
 
@@ -38,10 +69,40 @@ namespace VoxelEngine {
 
             result = m_queue.front();
             m_queue.pop();
+            m_size.store(m_queue.size(), std::memory_order_release);
+
+            return true;
+        }
+
+        //waits for at least one item, then appends up to count items to results
+        //returns false once the queue is cancelled, without dequeuing anything
+        bool dequeueUpTo(std::vector<T>& results, size_t count) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_condition.wait(lock, [this] { return m_cancel || !m_queue.empty(); });
+            if (m_cancel) return false;
+
+            size_t dequeued = std::min(count, m_queue.size());
+
+            for (size_t i = 0; i < dequeued; i++) {
+                results.push_back(m_queue.front());
+                m_queue.pop();
+            }
+
+            m_size.store(m_queue.size(), std::memory_order_release);
 
             return true;
         }
 
+        //may be stale by the time it returns, but never takes the lock
+        size_t size() const {
+            return m_size.load(std::memory_order_acquire);
+        }
+
+        size_t capacity() const {
+            return m_maxCount;
+        }
+
         void cancel() {
             std::unique_lock<std::mutex> lock(m_mutex);
 
@@ -54,6 +115,7 @@ namespace VoxelEngine {
         std::queue<T> m_queue;
         std::mutex m_mutex;
         std::condition_variable m_condition;
+        std::atomic<size_t> m_size;
         size_t m_maxCount;
         bool m_cancel;
     };
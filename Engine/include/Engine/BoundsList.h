@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+#include "Engine/Camera.h"
+
+namespace VoxelEngine {
+    //axis aligned boxes stored as one array per component, so that the frustum can be tested against several boxes at once
+    class BoundsList {
+    public:
+        size_t size() const { return m_ids.size(); }
+        uint32_t id(size_t index) const { return m_ids[index]; }
+        bool contains(uint32_t id) const { return m_indices.count(id) != 0; }
+
+        //adds the box, or moves it if the id is already in the list
+        void set(uint32_t id, glm::vec3 origin, glm::vec3 extent);
+        void remove(uint32_t id);
+        //adds a box with the next index as its id, without indexing it. for lists that are cleared and refilled every use,
+        //it can't be mixed with set or remove
+        void append(glm::vec3 origin, glm::vec3 extent);
+        void clear();
+
+        //appends the id of every box that is inside or intersects the frustum
+        void cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+    private:
+        std::vector<float> m_minX;
+        std::vector<float> m_minY;
+        std::vector<float> m_minZ;
+        std::vector<float> m_maxX;
+        std::vector<float> m_maxY;
+        std::vector<float> m_maxZ;
+        std::vector<uint32_t> m_ids;
+        std::unordered_map<uint32_t, size_t> m_indices;
+
+        void cullScalar(const Frustum& frustum, size_t start, std::vector<uint32_t>& visible) const;
+    };
+}
\ No newline at end of file
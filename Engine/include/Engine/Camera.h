@@ -15,6 +15,7 @@ namespace VoxelEngine {
 
         float distance(glm::vec3 p);
         bool testAABB(glm::vec3 origin, glm::vec3 extent);
+        bool containsAABB(glm::vec3 origin, glm::vec3 extent);
     };
 
     struct Frustum {
@@ -26,6 +27,8 @@ namespace VoxelEngine {
         Plane bottom;
 
         bool testAABB(glm::vec3 origin, glm::vec3 extent);
+        //true if the box is entirely inside the frustum
+        bool containsAABB(glm::vec3 origin, glm::vec3 extent);
     };
 
     class Camera {
@@ -37,6 +40,7 @@ namespace VoxelEngine {
         float fov() const { return m_fov; }
         float nearPlane() const { return m_nearPlane; }
         float farPlane() const { return m_farPlane; }
+        glm::vec3 position() const { return m_position; }
         glm::mat4 viewMatrix() const { return m_viewMatrix; }
         glm::mat4 projectionMatrix() const { return m_projectionMatrix; }
         Frustum frustum() const { return m_frustum; }
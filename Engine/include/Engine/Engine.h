@@ -1,20 +1,28 @@
 #pragma once
+#include "Engine/BoundsList.h"
 #include "Engine/Buffer.h"
 #include "Engine/Camera.h"
 #include "Engine/Clock.h"
+#include "Engine/FramePacer.h"
 #include "Engine/Mesh.h"
 #include "Engine/Graphics.h"
 #include "Engine/Image.h"
 #include "Engine/Input.h"
+#include "Engine/MappedFile.h"
 #include "Engine/MemoryManager.h"
 #include "Engine/Mesh.h"
+#include "Engine/Metrics.h"
+#include "Engine/Profiler.h"
 #include "Engine/RenderGraph/RenderGraph.h"
 #include "Engine/System.h"
+#include "Engine/ThreadPool.h"
 #include "Engine/Window.h"
 #include "FreeListAllocator.h"
+#include <atomic>
 
 namespace VoxelEngine {
     class RenderGraph;
+    enum class Key : int32_t;
 
     class Engine {
     public:
@@ -24,18 +32,41 @@ namespace VoxelEngine {
         Graphics& getGraphics() { return *m_graphics; }
         SystemGroup& getUpdateGroup() { return *m_updateGroup; }
         RenderGraph& renderGraph() { return *m_renderGraph; }
+        ThreadPool& threadPool() { return *m_threadPool; }
+
+        float targetFrameRate() const { return m_framePacer.frameRate(); }
+        void setTargetFrameRate(float frameRate);   //0 runs as fast as possible
 
         void run();
+        //updates the systems at a fixed rate without a window, until stop is called. tickRate must be positive
+        //the render graph is never executed unless a system in the update group does it
+        void runHeadless(float tickRate);
+        //safe to call from any thread
+        void stop();
 
         void addWindow(Window& window);
         void setRenderGraph(RenderGraph& renderGraph);
+        //worker threads are dropped to background priority while the window is minimized
+        void addWorkerThread(std::thread& thread);
+        //pressing key writes the profiler zones to path as a Chrome trace, when the profiler is compiled in
+        void setTraceKey(Key key, const std::string& path);
 
     private:
         Window* m_window;
         RenderGraph* m_renderGraph;
+        FramePacer m_framePacer;
+        std::atomic<bool> m_stop;
+        bool m_idle;
+        Key m_traceKey;
+        std::string m_tracePath;
+        std::vector<std::thread*> m_workerThreads;
 
         std::unique_ptr<SystemGroup> m_updateGroup;
         std::unique_ptr<Clock> m_updateClock;
         std::unique_ptr<Graphics> m_graphics;
+        std::unique_ptr<ThreadPool> m_threadPool;
+
+        void setIdle(bool idle);
+        void writeTrace();
     };
 }
\ No newline at end of file
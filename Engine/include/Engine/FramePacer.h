@@ -0,0 +1,26 @@
+#pragma once
+#include <chrono>
+
+namespace VoxelEngine {
+    //waits out the rest of each frame to hold a target frame rate. sleeps while the deadline is far away and spins for the last
+    //stretch, since sleeps can overshoot by a millisecond or more
+    class FramePacer {
+    public:
+        using Clock = std::chrono::steady_clock;
+
+        FramePacer();
+
+        float frameRate() const { return m_frameRate; }
+        void setFrameRate(float frameRate);    //0 disables pacing
+
+        void wait();
+
+    private:
+        static constexpr std::chrono::microseconds spinThreshold = std::chrono::microseconds(2000);
+
+        float m_frameRate;
+        Clock::duration m_period;
+        Clock::time_point m_next;
+        bool m_started;
+    };
+}
\ No newline at end of file
@@ -8,6 +8,7 @@ namespace VoxelEngine {
     class Graphics {
     public:
         Graphics();
+        ~Graphics();
 
         vk::Instance& instance() const { return *m_instance; }
         vk::Surface& surface() const { return*m_surface; }
@@ -18,12 +19,16 @@ namespace VoxelEngine {
         vk::Swapchain& swapchain() const { return *m_swapchain; }
         const std::vector<vk::ImageView>& swapchainImageViews() const { return m_swapchainImageViews; }
         MemoryManager& memory() const { return *m_memory; }
+        const vk::PhysicalDeviceFeatures2& enabledFeatures() const { return m_enabledFeatures; }
+        vk::PipelineCache& pipelineCache() const { return *m_pipelineCache; }
 
         entt::sink<void(vk::Swapchain&)>& onSwapchainChanged() { return m_onSwapchainChanged; }
 
+        //the window must be set before picking the physical device, without one the device has no swapchain
         void setWindow(Window& window);
         vk::PhysicalDeviceFeatures2 getSupportedFeatures();
         void pickPhysicalDevice(vk::PhysicalDeviceFeatures2* requestedFeatures);
+        void savePipelineCache();
 
     private:
         Window* m_window;
@@ -31,6 +36,8 @@ namespace VoxelEngine {
         std::unique_ptr<vk::Instance> m_instance;
         std::unique_ptr<vk::Surface> m_surface;
         std::unique_ptr<vk::Device> m_device;
+        std::unique_ptr<vk::PipelineCache> m_pipelineCache;
+        vk::PhysicalDeviceFeatures2 m_enabledFeatures;
 
         std::unique_ptr<MemoryManager> m_memory;
         const vk::Queue* m_graphicsQueue;
@@ -45,6 +52,7 @@ namespace VoxelEngine {
         void createInstance();
         void createSurface(Window& window);
         void createDevice(const vk::PhysicalDevice& physicalDevice, vk::PhysicalDeviceFeatures2* requestedFeatures, uint32_t graphicsIndex, uint32_t presentIndex, uint32_t transferIndex);
+        void createPipelineCache();
         void createSwapchain();
         void createImageViews();
 
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+namespace VoxelEngine {
+    //read only view of a file, the pages are loaded by the OS as they are touched
+    class MappedFile {
+    public:
+        MappedFile();
+        MappedFile(const MappedFile& other) = delete;
+        MappedFile& operator = (const MappedFile& other) = delete;
+        ~MappedFile();
+
+        //returns false if the file doesn't exist or is empty
+        bool open(const std::string& fileName);
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+        const uint8_t* data() const { return m_data; }
+        size_t size() const { return m_size; }
+
+    private:
+        const uint8_t* m_data;
+        size_t m_size;
+#ifdef _WIN32
+        void* m_file;
+        void* m_mapping;
+#else
+        int m_file;
+#endif
+    };
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include <array>
+#include <string>
+#include <fstream>
+#include <ostream>
+#include "Engine/System.h"
+
+namespace VoxelEngine {
+    class Counter {
+    public:
+        void add(uint64_t value = 1) { m_value.fetch_add(value, std::memory_order_relaxed); }
+        uint64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<uint64_t> m_value = { 0 };
+    };
+
+    class Gauge {
+    public:
+        void set(int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+        int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+    private:
+        std::atomic<int64_t> m_value = { 0 };
+    };
+
+    //log-linear histogram (like HdrHistogram). values below subBucketCount are exact,
+    //above that each power of two is split into subBucketCount buckets, so the relative error is at most 1 / subBucketCount
+    class Histogram {
+    public:
+        static const uint32_t subBucketBits = 4;
+        static const uint32_t subBucketCount = 1 << subBucketBits;
+        static const uint32_t bucketCount = (64 - subBucketBits + 1) * subBucketCount;
+
+        Histogram();
+
+        void record(uint64_t value);
+
+        uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+        uint64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+        uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+        double mean() const;
+        uint64_t percentile(double percentile) const;
+
+    private:
+        std::array<std::atomic<uint64_t>, bucketCount> m_buckets;
+        std::atomic<uint64_t> m_count;
+        std::atomic<uint64_t> m_sum;
+        std::atomic<uint64_t> m_max;
+
+        static uint32_t getBucket(uint64_t value);
+        static uint64_t getValue(uint32_t bucket);
+    };
+
+    //named counters, gauges and histograms shared by every thread. metrics are created on first use and never destroyed,
+    //so the returned references can be cached. durations are recorded in microseconds
+    class Metrics {
+    public:
+        static uint64_t now();
+
+        static Counter& counter(const std::string& name);
+        static Gauge& gauge(const std::string& name);
+        static Histogram& histogram(const std::string& name);
+
+        static void writeText(std::ostream& stream);
+        static void writeCsvHeader(std::ostream& stream);
+        static void writeCsv(std::ostream& stream, float time);
+    };
+
+    //appends every metric to a csv file at a fixed interval
+    class MetricsWriter : public System {
+    public:
+        MetricsWriter(const std::string& path, float interval);
+
+        void update(Clock& clock);
+
+    private:
+        std::ofstream m_stream;
+        float m_interval;
+        float m_timer;
+        float m_time;
+    };
+}
\ No newline at end of file
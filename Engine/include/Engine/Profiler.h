@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+
+namespace VoxelEngine {
+    //records named CPU zones into per thread ring buffers, which can be written out as a Chrome trace (chrome://tracing)
+    class Profiler {
+    public:
+        struct Zone {
+            const char* name;   //must be a string literal or otherwise outlive the profiler
+            uint64_t start;     //nanoseconds
+            uint64_t end;
+        };
+
+        static const size_t bufferSize = 65536;
+
+        static uint64_t now();
+        static bool enabled();
+        static void setEnabled(bool enabled);
+        static void setThreadName(const std::string& name);
+        static void record(const char* name, uint64_t start, uint64_t end);
+        static bool writeTrace(const std::string& path);
+    };
+
+    class ProfileScope {
+    public:
+        ProfileScope(const char* name) {
+            m_name = name;
+            m_start = Profiler::enabled() ? Profiler::now() : 0;
+        }
+
+        ~ProfileScope() {
+            if (m_start != 0) {
+                Profiler::record(m_name, m_start, Profiler::now());
+            }
+        }
+
+        ProfileScope(const ProfileScope& other) = delete;
+        ProfileScope& operator = (const ProfileScope& other) = delete;
+
+    private:
+        const char* m_name;
+        uint64_t m_start;
+    };
+}
+
+#define VOXEL_PROFILE_CONCAT_INNER(a, b) a##b
+#define VOXEL_PROFILE_CONCAT(a, b) VOXEL_PROFILE_CONCAT_INNER(a, b)
+
+#ifdef VOXEL_ENABLE_PROFILER
+#define VOXEL_PROFILE_SCOPE(name) VoxelEngine::ProfileScope VOXEL_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define VOXEL_PROFILE_THREAD(name) VoxelEngine::Profiler::setThreadName(name)
+#else
+#define VOXEL_PROFILE_SCOPE(name)
+#define VOXEL_PROFILE_THREAD(name)
+#endif
\ No newline at end of file
@@ -133,6 +133,9 @@ namespace VoxelEngine {
             RenderGraph& graph() const { return *m_graph; }
             const vk::Queue& queue() const { return *m_queue; }
             uint32_t currentFrame() const { return m_graph->currentFrame(); }
+            const std::string& name() const { return m_name; }
+            bool timestampSupported() const { return m_timestampSupported; }
+            float gpuTime() const { return m_gpuTime; }     //average over the last timestampHistory frames, in milliseconds
 
             void addExternalWait(vk::Semaphore& semaphore, vk::PipelineStageFlags stages);
             void addExternalSignal(vk::Semaphore& semaphore);
@@ -144,6 +147,14 @@ namespace VoxelEngine {
         protected:
             vk::CommandPool& commandPool() const { return *m_commandPool; }
 
+            void setName(const std::string& name) { m_name = name; }
+
+            //each secondary command buffer gets its own command pool, so they can be recorded from different threads at once
+            void createSecondaryCommandBuffers(uint32_t count);
+            uint32_t secondaryCommandBufferCount() const { return static_cast<uint32_t>(m_secondaryCommandPools.size()); }
+            vk::CommandBuffer& beginSecondaryCommandBuffer(uint32_t currentFrame, uint32_t index, vk::RenderPass& renderPass, uint32_t subpass, vk::Framebuffer& framebuffer);
+            void executeSecondaryCommandBuffers(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t count);
+
         private:
             std::unique_ptr<vk::Semaphore> m_semaphore;
 
@@ -154,6 +165,7 @@ namespace VoxelEngine {
             const vk::Queue* m_queue;
             vk::PipelineStageFlags m_stages;
             RenderGraph* m_graph;
+            std::string m_name;
             std::vector<Node*> m_outputNodes;
             std::vector<BufferUsage*> m_bufferUsages;
             std::vector<ImageUsage*> m_imageUsages;
@@ -162,9 +174,20 @@ namespace VoxelEngine {
 
             std::unique_ptr<vk::CommandPool> m_commandPool;
             std::vector<vk::CommandBuffer> m_commandBuffers;
+            std::vector<std::unique_ptr<vk::CommandPool>> m_secondaryCommandPools;
+            std::vector<std::vector<vk::CommandBuffer>> m_secondaryCommandBuffers;
+            std::vector<std::reference_wrapper<const vk::CommandBuffer>> m_secondaryExecutes;
             vk::SubmitInfo m_submitInfo;
             vk::TimelineSemaphoreSubmitInfo m_timelineSubmitInfo;
 
+            bool m_timestampSupported = false;
+            uint32_t m_timestampIndex = 0;
+            uint64_t m_timestampMask = 0;
+            std::vector<float> m_gpuTimes;
+            size_t m_gpuTimeIndex = 0;
+            size_t m_gpuTimeCount = 0;
+            float m_gpuTime = 0;
+
             void addOutput(Node& output, Edge& edge);
             void addUsage(BufferUsage& usage);
             void addUsage(ImageUsage& usage);
@@ -174,8 +197,11 @@ namespace VoxelEngine {
             void clearSync(uint32_t currentFrame);
             void internalRender(uint32_t currentFrame);
             void submit(uint32_t currentFrame);
+            void readTimestamp(const uint64_t* results, float timestampPeriod);
         };
 
+        static const size_t timestampHistory = 64;
+
         RenderGraph(vk::Device& device, uint32_t framesInFlight);
         ~RenderGraph();
 
@@ -183,6 +209,8 @@ namespace VoxelEngine {
         uint32_t framesInFlight() const { return m_framesInFlight; }
         uint32_t currentFrame() const { return m_currentFrame; }
         uint32_t frameCount() const { return m_frameCount; }
+        const std::vector<Node*>& nodes() const { return m_nodeList; }
+        bool timestampsEnabled() const { return m_timestampsEnabled; }
 
         template<class T, class... Args>
         T& addNode(Args&&... args) {
@@ -192,6 +220,7 @@ namespace VoxelEngine {
 
         void addEdge(BufferEdge&& edge);
         void addEdge(ImageEdge&& edge);
+        void enableTimestamps();
         void bake();
         void wait();
 
@@ -216,10 +245,18 @@ namespace VoxelEngine {
         std::vector<SemaphoreInfo> m_semaphores;
         vk::SemaphoreWaitInfo m_semaphoreWaitInfo;
 
+        bool m_timestampsEnabled = false;
+        float m_timestampPeriod = 0;
+        std::vector<std::unique_ptr<vk::QueryPool>> m_queryPools;
+        std::vector<bool> m_queryPoolsWritten;
+        std::vector<uint64_t> m_timestampResults;
+
         std::queue<std::vector<BufferState>> m_bufferDestroyQueue;
         std::queue<std::vector<ImageState>> m_imageDestroyQueue;
 
         void makeSemaphores();
+        void createQueryPools();
+        void readTimestamps(uint32_t currentFrame);
         void wait(uint32_t targetFrame);
     };
 }
\ No newline at end of file
@@ -13,19 +13,25 @@ namespace VoxelEngine {
 
         void setPriority(int32_t priority);
         int32_t getPriority() const;
+        //used to label the system's profiler zone
+        const char* name() const { return m_name; }
 
         virtual void update(Clock& clock) = 0;
 
     private:
         int32_t m_priority;
+        const char* m_name;
         SystemGroup* m_group;
+
+        friend class SystemGroup;
     };
 
     class SystemGroup {
     public:
         SystemGroup(Clock& clock);
 
-        void add(System& system, uint32_t priority);
+        //name must be a string literal or otherwise outlive the group
+        void add(System& system, uint32_t priority, const char* name);
         void remove(System& remove);
         void update();
 
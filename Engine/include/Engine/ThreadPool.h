@@ -0,0 +1,39 @@
+#pragma once
+#include <stdint.h>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+
+namespace VoxelEngine {
+    //fixed set of worker threads for splitting per frame work into tasks
+    class ThreadPool {
+    public:
+        ThreadPool(size_t threadCount);
+        ThreadPool(const ThreadPool& other) = delete;
+        ThreadPool& operator = (const ThreadPool& other) = delete;
+        ~ThreadPool();
+
+        size_t threadCount() const { return m_threads.size(); }
+
+        //calls task(i) for every i in [0, count) on the workers and the calling thread, returns when all tasks are finished
+        //only one thread may call run at a time
+        void run(size_t count, const std::function<void(size_t)>& task);
+
+    private:
+        std::vector<std::thread> m_threads;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::condition_variable m_doneCondition;
+        const std::function<void(size_t)>* m_task;
+        size_t m_count;
+        size_t m_next;
+        size_t m_remaining;
+        uint64_t m_generation;
+        bool m_stop;
+
+        void loop();
+        bool runTask(uint64_t generation);
+    };
+}
\ No newline at end of file
@@ -1,10 +1,21 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <thread>
 #include <VulkanWrapper/VulkanWrapper.h>
 
 namespace VoxelEngine {
+    enum class ThreadPriority {
+        Background,
+        Normal
+    };
+
     size_t align(size_t ptr, size_t alignment);
     std::vector<char> readFile(const std::string& filename);
+    //size of the data for a region of an image, block compressed formats store 4x4 texels per block
+    size_t getImageDataSize(vk::Format format, vk::Extent3D extent);
     vk::ShaderModule createShaderModule(vk::Device& device, const std::vector<char>& byteCode);
+    void setThreadPriority(std::thread& thread, ThreadPriority priority);
+    //stable sort of items by their upper 32 bits, scratch must be the same size as items
+    void radixSort(std::vector<uint64_t>& items, std::vector<uint64_t>& scratch);
 }
\ No newline at end of file
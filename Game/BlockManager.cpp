@@ -1,9 +1,74 @@
 #include "BlockManager.h"
+#include <fstream>
+#include <sstream>
+#include "TextureManager.h"
 
-BlockType::BlockType(uint32_t id, const FaceArray& faces, bool solid) {
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <tmmintrin.h>
+#define VOXEL_SSSE3
+
+#ifdef _MSC_VER
+#include <intrin.h>
+//MSVC allows intrinsics from any instruction set without a compiler flag
+#define VOXEL_TARGET_SSSE3
+#else
+#define VOXEL_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
+#ifdef VOXEL_SSSE3
+//the Game target is built for baseline x86-64, so SSSE3 support is checked once at startup
+static bool hasSSSE3() {
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+static const bool s_ssse3 = hasSSSE3();
+
+//pshufb only looks up 16 bytes, so the 32 byte table is split in half and the upper half is selected by bit 7 of the type
+VOXEL_TARGET_SSSE3 static uint32_t getMaskSSSE3(const uint8_t* flags, const Block* blocks, size_t count, size_t& i) {
+    uint32_t mask = 0;
+
+    const __m128i low = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&flags[0]));
+    const __m128i high = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&flags[16]));
+    const __m128i bits = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+    const __m128i seven = _mm_set1_epi8(7);
+    const __m128i fifteen = _mm_set1_epi8(15);
+
+    for (; i + 16 <= count; i += 16) {
+        __m128i types = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&blocks[i]));
+
+        //byte index is type >> 3, there is no 8 bit shift so shift 16 bit lanes and mask off the bits from the neighbor byte
+        __m128i byteIndex = _mm_and_si128(_mm_srli_epi16(types, 3), _mm_set1_epi8(31));
+        __m128i upper = _mm_cmpgt_epi8(byteIndex, fifteen);
+        byteIndex = _mm_and_si128(byteIndex, fifteen);
+
+        __m128i bytes = _mm_or_si128(
+            _mm_andnot_si128(upper, _mm_shuffle_epi8(low, byteIndex)),
+            _mm_and_si128(upper, _mm_shuffle_epi8(high, byteIndex))
+        );
+
+        __m128i bit = _mm_shuffle_epi8(bits, _mm_and_si128(types, seven));
+        __m128i set = _mm_cmpeq_epi8(_mm_and_si128(bytes, bit), bit);
+
+        mask |= static_cast<uint32_t>(_mm_movemask_epi8(set)) << i;
+    }
+
+    return mask;
+}
+#endif
+
+BlockType::BlockType(uint32_t id, const std::string& name, const FaceArray& faces, bool solid, uint8_t emission) {
     m_id = id;
+    m_name = name;
     m_faces = faces;
     m_solid = solid;
+    m_emission = emission;
 }
 
 bool BlockType::solid() const {
@@ -11,9 +76,159 @@ bool BlockType::solid() const {
 }
 
 BlockManager::BlockManager() {
-    m_types.emplace_back(0, BlockType::FaceArray{}, false);
-    m_types.emplace_back(1, BlockType::FaceArray{}, false);
-    m_types.emplace_back(2, BlockType::FaceArray{ 0, 0, 0, 0, 0, 0 });
-    m_types.emplace_back(3, BlockType::FaceArray{ 1, 1, 2, 0, 1, 1 });
-    m_types.emplace_back(4, BlockType::FaceArray{ 3, 3, 3, 3, 3, 3 });
+    //registering never moves the existing types
+    m_types.reserve(maxTypes);
+
+    m_solid = {};
+    m_opaque = {};
+    m_visible = {};
+    m_emission = {};
+    m_attenuation = {};
+    m_faceLayers = {};
+
+    registerType("null", BlockType::FaceArray{}, false);
+    registerType("air", BlockType::FaceArray{}, false);
+
+    //the null block is outside of the loaded chunks, faces next to it are hidden until the neighbor is loaded
+    setFlag(m_opaque, 0, true);
+    setFlag(m_visible, 0, false);
+    setFlag(m_visible, 1, false);
+}
+
+BlockType& BlockManager::registerType(const std::string& name, const BlockType::FaceArray& faces, bool solid, uint8_t emission) {
+    if (m_frozen) {
+        throw std::runtime_error("Block types can't be registered after the block manager is frozen: " + name);
+    }
+
+    if (m_types.size() == maxTypes) {
+        throw std::runtime_error("Too many block types");
+    }
+
+    if (m_names.count(name) > 0) {
+        throw std::runtime_error("Block type already registered: " + name);
+    }
+
+    uint32_t id = static_cast<uint32_t>(m_types.size());
+    m_types.emplace_back(id, name, faces, solid, emission);
+    m_names.insert({ name, id });
+
+    setFlag(m_solid, id, solid);
+    setFlag(m_opaque, id, solid);
+    setFlag(m_visible, id, true);
+    m_emission[id] = std::min<uint8_t>(emission, Light::maxLevel);
+    m_attenuation[id] = solid ? maxAttenuation : 0;
+
+    for (size_t i = 0; i < faces.size(); i++) {
+        m_faceLayers[(id * 6) + i] = static_cast<uint16_t>(faces[i]);
+    }
+
+    return m_types.back();
+}
+
+void BlockManager::freeze() {
+    m_frozen = true;
+}
+
+BlockType* BlockManager::findType(const std::string& name) {
+    auto it = m_names.find(name);
+    if (it != m_names.end()) {
+        return &m_types[it->second];
+    } else {
+        return nullptr;
+    }
+}
+
+void BlockManager::setFlag(Flags& flags, size_t type, bool value) {
+    uint8_t bit = static_cast<uint8_t>(1 << (type & 7));
+
+    if (value) {
+        flags[type >> 3] |= bit;
+    } else {
+        flags[type >> 3] &= static_cast<uint8_t>(~bit);
+    }
+}
+
+uint32_t BlockManager::getMask(const Flags& flags, const Block* blocks, size_t count) {
+    uint32_t mask = 0;
+    size_t i = 0;
+
+#ifdef VOXEL_SSSE3
+    if (s_ssse3) {
+        mask = getMaskSSSE3(flags.data(), blocks, count, i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        if (testFlag(flags, blocks[i])) {
+            mask |= 1u << i;
+        }
+    }
+
+    return mask;
+}
+
+void BlockManager::loadManifest(const std::string& fileName, TextureManager& textureManager) {
+    std::ifstream file(fileName);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Could not open block manifest " + fileName);
+    }
+
+    std::string line;
+    size_t lineNumber = 0;
+
+    while (std::getline(file, line)) {
+        lineNumber++;
+        std::istringstream stream(line);
+        std::string name;
+        std::string solid;
+
+        if (!(stream >> name)) continue;
+        if (name[0] == '#') continue;
+
+        std::string location = fileName + ":" + std::to_string(lineNumber) + ": block type " + name;
+
+        if (findType(name) != nullptr) {
+            throw std::runtime_error(location + " is already registered");
+        }
+
+        stream >> solid;
+
+        if (solid != "solid" && solid != "empty") {
+            throw std::runtime_error(location + " must be solid or empty");
+        }
+
+        std::vector<std::string> textures;
+        std::string texture;
+        uint8_t emission = 0;
+
+        while (stream >> texture) {
+            if (texture.compare(0, 6, "light=") == 0) {
+                std::string value = texture.substr(6);
+
+                //at most two digits, so stoi can't throw
+                bool digits = !value.empty() && value.size() <= 2 && value.find_first_not_of("0123456789") == std::string::npos;
+
+                if (!digits || std::stoi(value) > Light::maxLevel) {
+                    throw std::runtime_error(location + " has an invalid light level " + value);
+                }
+
+                emission = static_cast<uint8_t>(std::stoi(value));
+            } else {
+                textures.push_back(texture);
+            }
+        }
+
+        if (textures.size() != 1 && textures.size() != 6) {
+            throw std::runtime_error(location + " must have 1 or 6 textures");
+        }
+
+        BlockType::FaceArray faces = {};
+
+        for (size_t i = 0; i < faces.size(); i++) {
+            faces[i] = textureManager.registerTexture(textures[textures.size() == 1 ? 0 : i]);
+        }
+
+        registerType(name, faces, solid == "solid", emission);
+    }
 }
\ No newline at end of file
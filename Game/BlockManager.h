@@ -2,31 +2,87 @@
 #include <stdint.h>
 #include <vector>
 #include <array>
+#include <string>
+#include <unordered_map>
 #include "Chunk.h"
 
+class TextureManager;
+
 class BlockType {
 public:
     using FaceArray = std::array<size_t, 6>;
 
-    BlockType(uint32_t id, const FaceArray& faces, bool solid = true);
+    BlockType(uint32_t id, const std::string& name, const FaceArray& faces, bool solid = true, uint8_t emission = 0);
 
+    uint32_t id() const { return m_id; }
+    const std::string& name() const { return m_name; }
     size_t getFaceIndex(size_t index) const { return m_faces[index]; }
     bool solid() const;
+    uint8_t emission() const { return m_emission; }
 
 private:
     uint32_t m_id;
+    std::string m_name;
     FaceArray m_faces;
     bool m_solid;
+    uint8_t m_emission;
 };
 
+//the properties used by lighting, meshing and raycasts are also kept in flat tables indexed by block type
+//Block::type is 8 bits, so the tables have a fixed size and lookups don't need a bounds check
 class BlockManager {
 public:
+    static const size_t maxTypes = 256;
+    //light can't pass through a block with this attenuation
+    static const uint8_t maxAttenuation = 15;
+
     BlockManager();
 
     size_t typeCount() const { return m_types.size(); }
     BlockType& getType(size_t id) { return m_types[id]; }
     BlockType& getType(Block block) { return m_types[block.type]; }
 
+    //blocks raycasts
+    bool solid(Block block) const { return testFlag(m_solid, block); }
+    //hides the faces of the blocks next to it
+    bool opaque(Block block) const { return testFlag(m_opaque, block); }
+    //has faces to mesh
+    bool visible(Block block) const { return testFlag(m_visible, block); }
+    uint8_t emission(Block block) const { return m_emission[block.type]; }
+    uint8_t lightAttenuation(Block block) const { return m_attenuation[block.type]; }
+    uint32_t faceLayer(Block block, size_t face) const { return m_faceLayers[(block.type * 6) + face]; }
+
+    //bit i of the result is set if blocks[i] has the property, count must be at most 32
+    uint32_t opaqueMask(const Block* blocks, size_t count) const { return getMask(m_opaque, blocks, count); }
+    uint32_t visibleMask(const Block* blocks, size_t count) const { return getMask(m_visible, blocks, count); }
+
+    //ids are assigned in order of registration
+    //the worker threads read the tables without locking, so types must be registered before freeze() is called
+    BlockType& registerType(const std::string& name, const BlockType::FaceArray& faces, bool solid = true, uint8_t emission = 0);
+    void freeze();
+    bool frozen() const { return m_frozen; }
+    BlockType* findType(const std::string& name);
+
+    //each line of the manifest is "name solid|empty [light=N] texture" or "name solid|empty [light=N] texture x6"
+    //faces are in the order of Chunk::Neighbors6, a malformed line throws with the file and line number
+    void loadManifest(const std::string& fileName, TextureManager& textureManager);
+
 private:
+    //one bit per block type
+    using Flags = std::array<uint8_t, maxTypes / 8>;
+
     std::vector<BlockType> m_types;
+    std::unordered_map<std::string, uint32_t> m_names;
+    bool m_frozen = false;
+
+    Flags m_solid;
+    Flags m_opaque;
+    Flags m_visible;
+    std::array<uint8_t, maxTypes> m_emission;
+    std::array<uint8_t, maxTypes> m_attenuation;
+    std::array<uint16_t, maxTypes * 6> m_faceLayers;
+
+    static bool testFlag(const Flags& flags, Block block) { return ((flags[block.type >> 3] >> (block.type & 7)) & 1) != 0; }
+    static void setFlag(Flags& flags, size_t type, bool value);
+    static uint32_t getMask(const Flags& flags, const Block* blocks, size_t count);
 };
\ No newline at end of file
@@ -2,21 +2,19 @@
 #include "World.h"
 
 bool Light::operator > (Light& other) {
-    return sun > other.sun;
+    return sun() > other.sun() || block() > other.block();
 }
 
 bool Light::operator < (Light& other) {
-    return sun < other.sun;
+    return other > *this;
 }
 
 bool Light::operator == (Light& other) {
-    return sun == other.sun;
+    return value == other.value;
 }
 
 void Light::overwrite(Light& other) {
-    if (other.sun > sun) {
-        sun = other.sun;
-    }
+    *this = Light(std::max(sun(), other.sun()), std::max(block(), other.block()));
 }
 
 Chunk::PositionIterator::PositionIterator() {
@@ -68,10 +66,16 @@ Chunk::Chunk(entt::entity entity, glm::ivec3 pos, World& world) : m_neighbors()
     m_worldChunkPosition = pos;
     m_world = &world;
     m_loadState = ChunkLoadState::Loading;
+    m_connectivity = allConnected;
+    m_lod = 0;
+    m_meshLod = 0;
+    m_loadStart = 0;
+    m_editGeneration = 0;
 
     m_neighbors[1][1][1] = entity;
 
     m_blockUpdates = std::make_unique<VoxelEngine::BufferedQueue<BlockUpdate>>();
+    m_regionUpdates = std::make_unique<VoxelEngine::BufferedQueue<RegionUpdate>>();
     m_lightUpdates = std::make_unique<VoxelEngine::BufferedQueue<LightUpdate>>();
 
     m_blocks = std::make_unique<ChunkData<Block, chunkSize>>();
@@ -80,6 +84,18 @@ Chunk::Chunk(entt::entity entity, glm::ivec3 pos, World& world) : m_neighbors()
 
 void Chunk::reset() {
     m_lightUpdates->clear();
+    m_connectivity = allConnected;
+    m_lod = 0;
+    m_meshLod = 0;
+}
+
+uint16_t Chunk::connectionBit(size_t faceA, size_t faceB) {
+    if (faceA == faceB) return 0;
+    if (faceA > faceB) std::swap(faceA, faceB);
+
+    //index of the pair in the upper triangle of a 6x6 matrix
+    size_t index = faceA * (11 - faceA) / 2 + faceB - faceA - 1;
+    return static_cast<uint16_t>(1 << index);
 }
 
 entt::entity Chunk::neighbor(glm::ivec3 offset) {
@@ -164,6 +180,12 @@ void Chunk::queueBlockUpdate(BlockUpdate update) {
     m_world->queueChunkUpdate(m_worldChunkPosition);
 }
 
+void Chunk::queueRegionUpdates(const std::vector<RegionUpdate>& updates) {
+    for (auto& update : updates) {
+        m_regionUpdates->enqueue(update);
+    }
+}
+
 const std::array<glm::ivec3, 6> Chunk::Neighbors6 = {
     glm::ivec3(1, 0, 0),    //right
     glm::ivec3(-1, 0, 0),   //left
@@ -4,6 +4,9 @@
 #include <Engine/BlockingQueue.h>
 #include <Engine/BufferedQueue.h>
 #include <array>
+#include <algorithm>
+#include <memory>
+#include <vector>
 #include <entt/entt.hpp>
 
 class World;
@@ -33,23 +36,33 @@ struct Block {
     Block(size_t type) : type(static_cast<uint8_t>(type)) {}
 };
 
+//sun light in the low 4 bits, light from emissive blocks in the high 4 bits
 struct Light {
-    int8_t sun;
+    static constexpr int32_t maxLevel = 15;
 
-    Light() : sun(0) {}
-    Light(int32_t sun) : sun(static_cast<int8_t>(sun)) {}
+    uint8_t value;
 
+    Light() : value(0) {}
+    Light(int32_t sun, int32_t block = 0) : value(static_cast<uint8_t>(std::clamp(sun, 0, maxLevel) | (std::clamp(block, 0, maxLevel) << 4))) {}
+
+    int32_t sun() const { return value & 15; }
+    int32_t block() const { return value >> 4; }
+
+    //true if either channel is brighter than in other
     bool operator > (Light& other);
     bool operator < (Light& other);
     bool operator == (Light& other);
 
+    //keeps the brighter value of each channel
     void overwrite(Light& other);
 };
 
+//a removal clears the block light at inChunkPos if it was lit by a neighbor brighter than light.block()
 struct LightUpdate {
     Light light;
     glm::ivec3 inChunkPos;
     bool forcePropagation = false;
+    bool removal = false;
 };
 
 struct BlockUpdate {
@@ -57,6 +70,33 @@ struct BlockUpdate {
     glm::ivec3 inChunkPos;
 };
 
+//blocks copied out of the world, x is the innermost axis
+struct BlockRegion {
+    glm::ivec3 size;
+    std::vector<Block> blocks;
+
+    size_t index(glm::ivec3 pos) const {
+        return pos.x + (pos.y * size.x) + (pos.z * size.x * size.y);
+    }
+};
+
+enum class RegionOperation {
+    Fill,
+    Replace,
+    Paste
+};
+
+//edit of a box of blocks inside one chunk, min and max are inclusive
+struct RegionUpdate {
+    RegionOperation operation;
+    glm::ivec3 min;
+    glm::ivec3 max;
+    Block block;
+    Block from;                                 //replace only
+    std::shared_ptr<const BlockRegion> source;  //paste only
+    glm::ivec3 sourcePos;                       //position of min in the source region
+};
+
 template <typename T, size_t Size>
 class ChunkData {
 public:
@@ -75,6 +115,10 @@ public:
         return m_data[index(pos)];
     }
 
+    const T& operator [] (glm::ivec3 pos) const {
+        return m_data[index(pos)];
+    }
+
     static size_t index(glm::ivec3 pos) {
         return pos.x + (pos.y * Size) + (pos.z * Size * Size);
     }
@@ -100,6 +144,7 @@ private:
 class Chunk {
 public:
     static const int32_t chunkSize = 16;
+    static const uint16_t allConnected = 0x7FFF;
 
     struct Positions;
 
@@ -150,6 +195,28 @@ public:
     ChunkLoadState loadState() const { return m_loadState; }
     void setLoadState(ChunkLoadState loadState) { m_loadState = loadState; }
 
+    //one bit for each pair of Neighbors6 faces that can see each other through the chunk
+    uint16_t connectivity() const { return m_connectivity; }
+    void setConnectivity(uint16_t connectivity) { m_connectivity = connectivity; }
+    bool connected(size_t faceA, size_t faceB) const { return (m_connectivity & connectionBit(faceA, faceB)) != 0; }
+    static uint16_t connectionBit(size_t faceA, size_t faceB);
+
+    //0 is full resolution, each level halves the resolution of the mesh
+    uint32_t lod() const { return m_lod; }
+    void setLod(uint32_t lod) { m_lod = lod; }
+
+    //level of detail of the most recently built mesh, which lags lod() while a remesh is pending
+    uint32_t meshLod() const { return m_meshLod; }
+    void setMeshLod(uint32_t lod) { m_meshLod = lod; }
+
+    //id of the latest edit committed to this chunk, only accessed under the world lock
+    uint64_t editGeneration() const { return m_editGeneration; }
+    void setEditGeneration(uint64_t generation) { m_editGeneration = generation; }
+
+    //time the chunk's column was created, cleared once the first mesh is uploaded
+    uint64_t loadStart() const { return m_loadStart; }
+    void setLoadStart(uint64_t loadStart) { m_loadStart = loadStart; }
+
     entt::entity neighbor(glm::ivec3 offset);
     void setNeighbor(glm::ivec3 offset, entt::entity chunk);
 
@@ -172,9 +239,12 @@ public:
 
     void queueLightUpdate(LightUpdate update);
     void queueBlockUpdate(BlockUpdate update);
+    //does not queue a chunk update, the caller is responsible for that
+    void queueRegionUpdates(const std::vector<RegionUpdate>& updates);
 
     std::queue<LightUpdate>& getLightUpdates() { return m_lightUpdates->swapDequeue(); };
     std::queue<BlockUpdate>& getBlockUpdates() { return m_blockUpdates->swapDequeue(); };
+    std::queue<RegionUpdate>& getRegionUpdates() { return m_regionUpdates->swapDequeue(); };
 
     static const std::array<glm::ivec3, 6> Neighbors6;
     static const std::array<glm::ivec3, 4> Neighbors4;
@@ -201,7 +271,13 @@ private:
     std::unique_ptr<ChunkData<Block, chunkSize>> m_blocks;
     std::unique_ptr<ChunkData<Light, chunkSize>> m_light;
     ChunkLoadState m_loadState;
+    uint16_t m_connectivity;
+    uint32_t m_lod;
+    uint32_t m_meshLod;
+    uint64_t m_loadStart;
+    uint64_t m_editGeneration;
     std::array<std::array<std::array<entt::entity, 3>, 3>, 3 > m_neighbors;
     std::unique_ptr<VoxelEngine::BufferedQueue<BlockUpdate>> m_blockUpdates;
+    std::unique_ptr<VoxelEngine::BufferedQueue<RegionUpdate>> m_regionUpdates;
     std::unique_ptr<VoxelEngine::BufferedQueue<LightUpdate>> m_lightUpdates;
 };
\ No newline at end of file
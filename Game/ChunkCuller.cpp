@@ -0,0 +1,530 @@
+#include "ChunkCuller.h"
+#include "ChunkRenderer.h"
+#include <Engine/Utilities.h>
+#include <algorithm>
+#include <cstring>
+
+ChunkCuller::ChunkCuller(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::CameraSystem& cameraSystem, ChunkRenderer& chunkRenderer)
+    : VoxelEngine::RenderGraph::Node(graph, *engine.getGraphics().graphicsQueue(), vk::PipelineStageFlags::ComputeShader) {
+    setName("ChunkCuller");
+    m_engine = &engine;
+    m_graphics = &engine.getGraphics();
+    m_cameraSystem = &cameraSystem;
+    m_chunkRenderer = &chunkRenderer;
+    m_prevViewProj = glm::mat4(1);
+    m_pyramidValid = false;
+
+    m_commandUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::ShaderWrite, vk::PipelineStageFlags::ComputeShader);
+
+    if (!m_chunkRenderer->indirectSupported()) return;
+
+    createUniformBuffers();
+    createSampler();
+    createPyramid();
+    createPyramidDescriptorSetLayout();
+    createCullDescriptorSetLayout();
+    createPyramidDescriptorSets();
+    createCullDescriptorSets();
+    writeCullDescriptorSets();
+    createPipelineLayouts();
+    createPipelines();
+
+    m_graphics->onSwapchainChanged().connect<&ChunkCuller::onSwapchainChanged>(this);
+}
+
+void ChunkCuller::preRender(uint32_t currentFrame) {
+    if (!m_chunkRenderer->indirectSupported()) return;
+
+    m_commandUsage->sync(m_chunkRenderer->culledBuffer(currentFrame), VK_WHOLE_SIZE, 0);
+    m_commandUsage->sync(m_chunkRenderer->countBuffer(currentFrame), VK_WHOLE_SIZE, 0);
+}
+
+void ChunkCuller::render(uint32_t currentFrame, vk::CommandBuffer& commandBuffer) {
+    if (!m_chunkRenderer->indirectSupported()) return;
+
+    m_chunkRenderer->writeDraws(currentFrame);
+    updateUniform(currentFrame);
+
+    if (m_pyramidValid) {
+        buildPyramid(commandBuffer);
+    }
+
+    uint32_t drawCount = m_chunkRenderer->drawCount();
+    if (drawCount == 0) return;
+
+    //counts are only read by drawIndexedIndirectCount, but clear them either way
+    commandBuffer.fillBuffer(m_chunkRenderer->countBuffer(currentFrame).buffer(), 0, drawCount * sizeof(uint32_t), 0);
+
+    vk::BufferMemoryBarrier barrier = {};
+    barrier.buffer = &m_chunkRenderer->countBuffer(currentFrame).buffer();
+    barrier.offset = 0;
+    barrier.size = drawCount * sizeof(uint32_t);
+    barrier.srcAccessMask = vk::AccessFlags::TransferWrite;
+    barrier.dstAccessMask = vk::AccessFlags::ShaderRead | vk::AccessFlags::ShaderWrite;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlags::Transfer, vk::PipelineStageFlags::ComputeShader, {},
+        nullptr,
+        barrier,
+        nullptr
+    );
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::Compute, *m_cullPipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Compute, *m_cullPipelineLayout, 0, { m_cullDescriptorSets[currentFrame] }, nullptr);
+
+    if (m_chunkRenderer->compactDraws()) {
+        //one workgroup per batch, so each batch can be compacted in order
+        commandBuffer.dispatch(std::min(m_chunkRenderer->batchCount(), maxBatches), 1, 1);
+    } else {
+        commandBuffer.dispatch((drawCount + 63) / 64, 1, 1);
+    }
+}
+
+void ChunkCuller::postRender(uint32_t currentFrame) {
+    if (!m_chunkRenderer->indirectSupported()) return;
+
+    //the depth buffer written by this frame is used to cull the next one
+    m_pyramidValid = true;
+}
+
+void ChunkCuller::updateUniform(uint32_t currentFrame) {
+    VoxelEngine::Camera& camera = m_cameraSystem->camera();
+    VoxelEngine::Frustum frustum = camera.frustum();
+    vk::Extent3D pyramidSize = m_pyramid->extent();
+
+    CullUniform uniform = {};
+    uniform.viewProj = m_prevViewProj;
+    uniform.planes[0] = frustum.near.components;
+    uniform.planes[1] = frustum.far.components;
+    uniform.planes[2] = frustum.left.components;
+    uniform.planes[3] = frustum.right.components;
+    uniform.planes[4] = frustum.top.components;
+    uniform.planes[5] = frustum.bottom.components;
+    uniform.info.x = m_chunkRenderer->drawCount();
+    uniform.info.y = m_pyramidValid ? 1 : 0;
+    uniform.info.z = m_chunkRenderer->compactDraws() ? 1 : 0;
+    uniform.info.w = m_pyramid->image().mipLevels();
+    uniform.pyramidSize = glm::vec4(pyramidSize.width, pyramidSize.height, 0, 0);
+
+    uint32_t batchCount = std::min(m_chunkRenderer->batchCount(), maxBatches);
+
+    for (uint32_t i = 0; i < batchCount; i++) {
+        uniform.batches[i] = glm::uvec4(m_chunkRenderer->batchRange(i), 0, 0);
+    }
+
+    memcpy(m_uniformBuffers[currentFrame]->getMapping(), &uniform, sizeof(CullUniform));
+
+    m_prevViewProj = camera.projectionMatrix() * camera.viewMatrix();
+}
+
+void ChunkCuller::buildPyramid(vk::CommandBuffer& commandBuffer) {
+    VoxelEngine::Image& depthBuffer = m_chunkRenderer->depthBuffer();
+
+    vk::ImageMemoryBarrier depthBarrier = {};
+    depthBarrier.image = &depthBuffer.image();
+    depthBarrier.oldLayout = vk::ImageLayout::DepthStencilAttachmentOptimal;
+    depthBarrier.newLayout = vk::ImageLayout::ShaderReadOnlyOptimal;
+    depthBarrier.srcAccessMask = vk::AccessFlags::DepthStencilAttachmentWrite;
+    depthBarrier.dstAccessMask = vk::AccessFlags::ShaderRead;
+    depthBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    depthBarrier.subresourceRange.aspectMask = vk::ImageAspectFlags::Depth;
+    depthBarrier.subresourceRange.baseArrayLayer = 0;
+    depthBarrier.subresourceRange.layerCount = 1;
+    depthBarrier.subresourceRange.baseMipLevel = 0;
+    depthBarrier.subresourceRange.levelCount = 1;
+
+    //the previous contents of the pyramid are discarded
+    vk::ImageMemoryBarrier pyramidBarrier = {};
+    pyramidBarrier.image = &m_pyramid->image();
+    pyramidBarrier.oldLayout = vk::ImageLayout::Undefined;
+    pyramidBarrier.newLayout = vk::ImageLayout::General;
+    pyramidBarrier.srcAccessMask = vk::AccessFlags::ShaderRead;
+    pyramidBarrier.dstAccessMask = vk::AccessFlags::ShaderWrite;
+    pyramidBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pyramidBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    pyramidBarrier.subresourceRange.aspectMask = vk::ImageAspectFlags::Color;
+    pyramidBarrier.subresourceRange.baseArrayLayer = 0;
+    pyramidBarrier.subresourceRange.layerCount = 1;
+    pyramidBarrier.subresourceRange.baseMipLevel = 0;
+    pyramidBarrier.subresourceRange.levelCount = m_pyramid->image().mipLevels();
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlags::LateFragmentTests | vk::PipelineStageFlags::ComputeShader, vk::PipelineStageFlags::ComputeShader, {},
+        nullptr,
+        nullptr,
+        { depthBarrier, pyramidBarrier }
+    );
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::Compute, *m_pyramidPipeline);
+
+    vk::Extent3D depthExtent = depthBuffer.extent();
+    glm::ivec2 inputSize = { depthExtent.width, depthExtent.height };
+
+    for (uint32_t i = 0; i < m_pyramid->image().mipLevels(); i++) {
+        glm::ivec2 outputSize = glm::max(inputSize / 2, glm::ivec2(1));
+        glm::ivec4 info = { inputSize, outputSize };
+
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Compute, *m_pyramidPipelineLayout, 0, { m_pyramidDescriptorSets[i] }, nullptr);
+        commandBuffer.pushConstants(*m_pyramidPipelineLayout, vk::ShaderStageFlags::Compute, 0, sizeof(glm::ivec4), &info);
+        commandBuffer.dispatch((outputSize.x + 7) / 8, (outputSize.y + 7) / 8, 1);
+
+        //level i is read when generating level (i + 1) and by the cull shader
+        vk::ImageMemoryBarrier barrier = {};
+        barrier.image = &m_pyramid->image();
+        barrier.oldLayout = vk::ImageLayout::General;
+        barrier.newLayout = vk::ImageLayout::General;
+        barrier.srcAccessMask = vk::AccessFlags::ShaderWrite;
+        barrier.dstAccessMask = vk::AccessFlags::ShaderRead;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.subresourceRange.aspectMask = vk::ImageAspectFlags::Color;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.baseMipLevel = i;
+        barrier.subresourceRange.levelCount = 1;
+
+        commandBuffer.pipelineBarrier(vk::PipelineStageFlags::ComputeShader, vk::PipelineStageFlags::ComputeShader, {},
+            nullptr,
+            nullptr,
+            barrier
+        );
+
+        inputSize = outputSize;
+    }
+
+    //give the depth buffer back to ChunkRenderer
+    depthBarrier.oldLayout = vk::ImageLayout::ShaderReadOnlyOptimal;
+    depthBarrier.newLayout = vk::ImageLayout::DepthStencilAttachmentOptimal;
+    depthBarrier.srcAccessMask = vk::AccessFlags::ShaderRead;
+    depthBarrier.dstAccessMask = vk::AccessFlags::DepthStencilAttachmentRead | vk::AccessFlags::DepthStencilAttachmentWrite;
+
+    commandBuffer.pipelineBarrier(vk::PipelineStageFlags::ComputeShader, vk::PipelineStageFlags::EarlyFragmentTests | vk::PipelineStageFlags::LateFragmentTests, {},
+        nullptr,
+        nullptr,
+        depthBarrier
+    );
+}
+
+void ChunkCuller::createUniformBuffers() {
+    vk::BufferCreateInfo info = {};
+    info.size = sizeof(CullUniform);
+    info.usage = vk::BufferUsageFlags::UniformBuffer;
+    info.sharingMode = vk::SharingMode::Exclusive;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        m_uniformBuffers.emplace_back(std::make_unique<VoxelEngine::Buffer>(*m_engine, info, allocInfo));
+    }
+}
+
+void ChunkCuller::createPyramid() {
+    vk::Extent3D depthExtent = m_chunkRenderer->depthBuffer().extent();
+    uint32_t width = std::max(depthExtent.width / 2, 1u);
+    uint32_t height = std::max(depthExtent.height / 2, 1u);
+    uint32_t mipLevels = 1;
+
+    while ((std::max(width, height) >> mipLevels) > 0) {
+        mipLevels++;
+    }
+
+    vk::ImageCreateInfo info = {};
+    info.extent = { width, height, 1 };
+    info.format = vk::Format::R32_Sfloat;
+    info.usage = vk::ImageUsageFlags::Storage | vk::ImageUsageFlags::Sampled;
+    info.mipLevels = mipLevels;
+    info.arrayLayers = 1;
+    info.samples = vk::SampleCountFlags::_1;
+    info.imageType = vk::ImageType::_2D;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    m_pyramid = std::make_unique<VoxelEngine::Image>(*m_engine, info, allocInfo);
+
+    vk::ImageViewCreateInfo viewInfo = {};
+    viewInfo.image = &m_pyramid->image();
+    viewInfo.format = m_pyramid->image().format();
+    viewInfo.viewType = vk::ImageViewType::_2D;
+    viewInfo.subresourceRange.aspectMask = vk::ImageAspectFlags::Color;
+    viewInfo.subresourceRange.baseArrayLayer = 0;
+    viewInfo.subresourceRange.layerCount = 1;
+    viewInfo.subresourceRange.baseMipLevel = 0;
+    viewInfo.subresourceRange.levelCount = mipLevels;
+
+    m_pyramidView = std::make_unique<vk::ImageView>(m_graphics->device(), viewInfo);
+
+    m_pyramidMipViews.clear();
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        viewInfo.subresourceRange.baseMipLevel = i;
+        viewInfo.subresourceRange.levelCount = 1;
+
+        m_pyramidMipViews.emplace_back(m_graphics->device(), viewInfo);
+    }
+}
+
+void ChunkCuller::createSampler() {
+    vk::SamplerCreateInfo info = {};
+    info.magFilter = vk::Filter::Nearest;
+    info.minFilter = vk::Filter::Nearest;
+    info.mipmapMode = vk::SamplerMipmapMode::Nearest;
+    info.addressModeU = vk::SamplerAddressMode::ClampToEdge;
+    info.addressModeV = vk::SamplerAddressMode::ClampToEdge;
+    info.minLod = 0;
+    info.maxLod = VK_LOD_CLAMP_NONE;
+
+    m_sampler = std::make_unique<vk::Sampler>(m_graphics->device(), info);
+}
+
+void ChunkCuller::createPyramidDescriptorSetLayout() {
+    vk::DescriptorSetLayoutBinding binding1 = {};
+    binding1.binding = 0;
+    binding1.descriptorType = vk::DescriptorType::CombinedImageSampler;
+    binding1.descriptorCount = 1;
+    binding1.stageFlags = vk::ShaderStageFlags::Compute;
+
+    vk::DescriptorSetLayoutBinding binding2 = {};
+    binding2.binding = 1;
+    binding2.descriptorType = vk::DescriptorType::StorageImage;
+    binding2.descriptorCount = 1;
+    binding2.stageFlags = vk::ShaderStageFlags::Compute;
+
+    vk::DescriptorSetLayoutCreateInfo info = {};
+    info.bindings = {
+        binding1,
+        binding2
+    };
+
+    m_pyramidDescriptorSetLayout = std::make_unique<vk::DescriptorSetLayout>(m_graphics->device(), info);
+}
+
+void ChunkCuller::createCullDescriptorSetLayout() {
+    std::vector<vk::DescriptorSetLayoutBinding> bindings;
+
+    vk::DescriptorSetLayoutBinding uniformBinding = {};
+    uniformBinding.binding = 0;
+    uniformBinding.descriptorType = vk::DescriptorType::UniformBuffer;
+    uniformBinding.descriptorCount = 1;
+    uniformBinding.stageFlags = vk::ShaderStageFlags::Compute;
+    bindings.push_back(uniformBinding);
+
+    //commands, transforms, culled commands, counts
+    for (uint32_t i = 1; i <= 4; i++) {
+        vk::DescriptorSetLayoutBinding binding = {};
+        binding.binding = i;
+        binding.descriptorType = vk::DescriptorType::StorageBuffer;
+        binding.descriptorCount = 1;
+        binding.stageFlags = vk::ShaderStageFlags::Compute;
+        bindings.push_back(binding);
+    }
+
+    vk::DescriptorSetLayoutBinding pyramidBinding = {};
+    pyramidBinding.binding = 5;
+    pyramidBinding.descriptorType = vk::DescriptorType::CombinedImageSampler;
+    pyramidBinding.descriptorCount = 1;
+    pyramidBinding.stageFlags = vk::ShaderStageFlags::Compute;
+    bindings.push_back(pyramidBinding);
+
+    vk::DescriptorSetLayoutCreateInfo info = {};
+    info.bindings = bindings;
+
+    m_cullDescriptorSetLayout = std::make_unique<vk::DescriptorSetLayout>(m_graphics->device(), info);
+}
+
+void ChunkCuller::createPyramidDescriptorSets() {
+    uint32_t mipLevels = m_pyramid->image().mipLevels();
+
+    //the pool is recreated with the pyramid, since the number of mip levels can change
+    vk::DescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.maxSets = mipLevels;
+    poolInfo.poolSizes = {
+        { vk::DescriptorType::CombinedImageSampler, mipLevels },
+        { vk::DescriptorType::StorageImage, mipLevels }
+    };
+
+    m_pyramidDescriptorSets.clear();
+    m_pyramidDescriptorPool = std::make_unique<vk::DescriptorPool>(m_graphics->device(), poolInfo);
+
+    vk::DescriptorSetAllocateInfo info = {};
+    info.descriptorPool = m_pyramidDescriptorPool.get();
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        info.setLayouts.push_back(*m_pyramidDescriptorSetLayout);
+    }
+
+    m_pyramidDescriptorSets = m_pyramidDescriptorPool->allocate(info);
+
+    std::vector<vk::DescriptorImageInfo> inputInfos;
+    std::vector<vk::DescriptorImageInfo> outputInfos;
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        //level 0 is reduced from the depth buffer, every other level from the level before it
+        vk::DescriptorImageInfo inputInfo = {};
+        inputInfo.sampler = m_sampler.get();
+
+        if (i == 0) {
+            inputInfo.imageView = &m_chunkRenderer->depthBufferView();
+            inputInfo.imageLayout = vk::ImageLayout::ShaderReadOnlyOptimal;
+        } else {
+            inputInfo.imageView = &m_pyramidMipViews[i - 1];
+            inputInfo.imageLayout = vk::ImageLayout::General;
+        }
+
+        vk::DescriptorImageInfo outputInfo = {};
+        outputInfo.imageView = &m_pyramidMipViews[i];
+        outputInfo.imageLayout = vk::ImageLayout::General;
+
+        inputInfos.push_back(inputInfo);
+        outputInfos.push_back(outputInfo);
+    }
+
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        vk::WriteDescriptorSet write1 = {};
+        write1.imageInfo = { inputInfos[i] };
+        write1.dstSet = &m_pyramidDescriptorSets[i];
+        write1.dstBinding = 0;
+        write1.descriptorType = vk::DescriptorType::CombinedImageSampler;
+
+        vk::WriteDescriptorSet write2 = {};
+        write2.imageInfo = { outputInfos[i] };
+        write2.dstSet = &m_pyramidDescriptorSets[i];
+        write2.dstBinding = 1;
+        write2.descriptorType = vk::DescriptorType::StorageImage;
+
+        writes.push_back(write1);
+        writes.push_back(write2);
+    }
+
+    vk::DescriptorSet::update(m_graphics->device(), writes, nullptr);
+}
+
+void ChunkCuller::createCullDescriptorSets() {
+    vk::DescriptorPoolCreateInfo poolInfo = {};
+    poolInfo.maxSets = graph().framesInFlight();
+    poolInfo.poolSizes = {
+        { vk::DescriptorType::UniformBuffer, graph().framesInFlight() },
+        { vk::DescriptorType::StorageBuffer, graph().framesInFlight() * 4 },
+        { vk::DescriptorType::CombinedImageSampler, graph().framesInFlight() }
+    };
+
+    m_cullDescriptorPool = std::make_unique<vk::DescriptorPool>(m_graphics->device(), poolInfo);
+
+    vk::DescriptorSetAllocateInfo info = {};
+    info.descriptorPool = m_cullDescriptorPool.get();
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        info.setLayouts.push_back(*m_cullDescriptorSetLayout);
+    }
+
+    m_cullDescriptorSets = m_cullDescriptorPool->allocate(info);
+}
+
+void ChunkCuller::writeCullDescriptorSets() {
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        vk::DescriptorBufferInfo uniformInfo = {};
+        uniformInfo.buffer = &m_uniformBuffers[i]->buffer();
+        uniformInfo.range = sizeof(CullUniform);
+
+        vk::WriteDescriptorSet uniformWrite = {};
+        uniformWrite.dstSet = &m_cullDescriptorSets[i];
+        uniformWrite.dstBinding = 0;
+        uniformWrite.bufferInfo = { uniformInfo };
+        uniformWrite.descriptorType = vk::DescriptorType::UniformBuffer;
+        writes.push_back(uniformWrite);
+
+        VoxelEngine::Buffer* buffers[] = {
+            &m_chunkRenderer->indirectBuffer(i),
+            &m_chunkRenderer->transformBuffer(i),
+            &m_chunkRenderer->culledBuffer(i),
+            &m_chunkRenderer->countBuffer(i)
+        };
+
+        for (uint32_t j = 0; j < 4; j++) {
+            vk::DescriptorBufferInfo bufferInfo = {};
+            bufferInfo.buffer = &buffers[j]->buffer();
+            bufferInfo.range = VK_WHOLE_SIZE;
+
+            vk::WriteDescriptorSet write = {};
+            write.dstSet = &m_cullDescriptorSets[i];
+            write.dstBinding = j + 1;
+            write.bufferInfo = { bufferInfo };
+            write.descriptorType = vk::DescriptorType::StorageBuffer;
+            writes.push_back(write);
+        }
+
+        vk::DescriptorImageInfo pyramidInfo = {};
+        pyramidInfo.sampler = m_sampler.get();
+        pyramidInfo.imageView = m_pyramidView.get();
+        pyramidInfo.imageLayout = vk::ImageLayout::General;
+
+        vk::WriteDescriptorSet pyramidWrite = {};
+        pyramidWrite.dstSet = &m_cullDescriptorSets[i];
+        pyramidWrite.dstBinding = 5;
+        pyramidWrite.imageInfo = { pyramidInfo };
+        pyramidWrite.descriptorType = vk::DescriptorType::CombinedImageSampler;
+        writes.push_back(pyramidWrite);
+    }
+
+    vk::DescriptorSet::update(m_graphics->device(), writes, nullptr);
+}
+
+void ChunkCuller::createPipelineLayouts() {
+    vk::PipelineLayoutCreateInfo pyramidInfo = {};
+    pyramidInfo.setLayouts = { *m_pyramidDescriptorSetLayout };
+    pyramidInfo.pushConstantRanges = {
+        {
+            vk::ShaderStageFlags::Compute,
+            0,
+            sizeof(glm::ivec4)
+        }
+    };
+
+    m_pyramidPipelineLayout = std::make_unique<vk::PipelineLayout>(m_graphics->device(), pyramidInfo);
+
+    vk::PipelineLayoutCreateInfo cullInfo = {};
+    cullInfo.setLayouts = { *m_cullDescriptorSetLayout };
+
+    m_cullPipelineLayout = std::make_unique<vk::PipelineLayout>(m_graphics->device(), cullInfo);
+}
+
+void ChunkCuller::createPipelines() {
+    std::vector<char> pyramidShaderCode = VoxelEngine::readFile("shaders/hiz.comp.spv");
+    std::vector<char> cullShaderCode = VoxelEngine::readFile("shaders/cull.comp.spv");
+
+    vk::ShaderModule pyramidShader = VoxelEngine::createShaderModule(m_graphics->device(), pyramidShaderCode);
+    vk::ShaderModule cullShader = VoxelEngine::createShaderModule(m_graphics->device(), cullShaderCode);
+
+    vk::ComputePipelineCreateInfo pyramidInfo = {};
+    pyramidInfo.stage.module = &pyramidShader;
+    pyramidInfo.stage.name = "main";
+    pyramidInfo.stage.stage = vk::ShaderStageFlags::Compute;
+    pyramidInfo.layout = m_pyramidPipelineLayout.get();
+
+    m_pyramidPipeline = std::make_unique<vk::ComputePipeline>(m_graphics->device(), pyramidInfo, &m_graphics->pipelineCache());
+
+    vk::ComputePipelineCreateInfo cullInfo = {};
+    cullInfo.stage.module = &cullShader;
+    cullInfo.stage.name = "main";
+    cullInfo.stage.stage = vk::ShaderStageFlags::Compute;
+    cullInfo.layout = m_cullPipelineLayout.get();
+
+    m_cullPipeline = std::make_unique<vk::ComputePipeline>(m_graphics->device(), cullInfo, &m_graphics->pipelineCache());
+}
+
+void ChunkCuller::onSwapchainChanged(vk::Swapchain& swapchain) {
+    //ChunkRenderer recreates its depth buffer first, so the pyramid has to follow
+    m_pyramidValid = false;
+    createPyramid();
+    createPyramidDescriptorSets();
+    writeCullDescriptorSets();
+}
\ No newline at end of file
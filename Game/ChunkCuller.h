@@ -0,0 +1,74 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <Engine/Engine.h>
+#include <Engine/RenderGraph/RenderGraph.h>
+#include <Engine/CameraSystem.h>
+#include <glm/glm.hpp>
+#include "MeshManager.h"
+
+class ChunkRenderer;
+
+class ChunkCuller : public VoxelEngine::RenderGraph::Node {
+    //draws are batched by mesh page, so there is never more than one batch per page
+    static const uint32_t maxBatches = MeshManager::maxPages;
+
+    struct CullUniform {
+        glm::mat4 viewProj;
+        glm::vec4 planes[6];
+        glm::uvec4 info;
+        glm::vec4 pyramidSize;
+        glm::uvec4 batches[maxBatches];
+    };
+
+public:
+    ChunkCuller(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::CameraSystem& cameraSystem, ChunkRenderer& chunkRenderer);
+
+    VoxelEngine::RenderGraph::BufferUsage& commandUsage() const { return *m_commandUsage; }
+
+    void preRender(uint32_t currentFrame);
+    void render(uint32_t currentFrame, vk::CommandBuffer& commandBuffer);
+    void postRender(uint32_t currentFrame);
+
+private:
+    VoxelEngine::Engine* m_engine;
+    VoxelEngine::Graphics* m_graphics;
+    VoxelEngine::CameraSystem* m_cameraSystem;
+    ChunkRenderer* m_chunkRenderer;
+
+    std::vector<std::unique_ptr<VoxelEngine::Buffer>> m_uniformBuffers;
+    std::unique_ptr<VoxelEngine::Image> m_pyramid;
+    std::unique_ptr<vk::ImageView> m_pyramidView;
+    std::vector<vk::ImageView> m_pyramidMipViews;
+    std::unique_ptr<vk::Sampler> m_sampler;
+    std::unique_ptr<vk::DescriptorSetLayout> m_pyramidDescriptorSetLayout;
+    std::unique_ptr<vk::DescriptorSetLayout> m_cullDescriptorSetLayout;
+    std::unique_ptr<vk::DescriptorPool> m_pyramidDescriptorPool;
+    std::unique_ptr<vk::DescriptorPool> m_cullDescriptorPool;
+    std::vector<vk::DescriptorSet> m_pyramidDescriptorSets;
+    std::vector<vk::DescriptorSet> m_cullDescriptorSets;
+    std::unique_ptr<vk::PipelineLayout> m_pyramidPipelineLayout;
+    std::unique_ptr<vk::PipelineLayout> m_cullPipelineLayout;
+    std::unique_ptr<vk::Pipeline> m_pyramidPipeline;
+    std::unique_ptr<vk::Pipeline> m_cullPipeline;
+
+    std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_commandUsage;
+
+    glm::mat4 m_prevViewProj;
+    bool m_pyramidValid;
+
+    void createUniformBuffers();
+    void createPyramid();
+    void createSampler();
+    void createPyramidDescriptorSetLayout();
+    void createCullDescriptorSetLayout();
+    void createPyramidDescriptorSets();
+    void createCullDescriptorSets();
+    void writeCullDescriptorSets();
+    void createPipelineLayouts();
+    void createPipelines();
+
+    void updateUniform(uint32_t currentFrame);
+    void buildPyramid(vk::CommandBuffer& commandBuffer);
+
+    void onSwapchainChanged(vk::Swapchain& swapchain);
+};
\ No newline at end of file
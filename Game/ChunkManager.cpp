@@ -1,4 +1,5 @@
 #include "ChunkManager.h"
+#include <Engine/Metrics.h>
 #include "ChunkMesh.h"
 #include "TerrainGenerator.h"
 #include "ChunkUpdater.h"
@@ -8,9 +9,13 @@ ChunkGroup::ChunkGroup(glm::ivec2 coord, World& world) : m_neighbors() {
     m_coord = coord;
     m_world = &world;
     m_loadState = ChunkLoadState::Loading;
+    m_lod = 0;
+
+    uint64_t loadStart = VoxelEngine::Metrics::now();
 
     for (int32_t i = 0; i < World::worldHeight; i++) {
         entt::entity chunkEntity = m_world->createChunk(glm::ivec3(coord.x, i, coord.y));
+        m_world->registry().get<Chunk>(chunkEntity).setLoadStart(loadStart);
         m_chunks.push_back(chunkEntity);
     }
 }
@@ -31,6 +36,16 @@ void ChunkGroup::setLoadState(ChunkLoadState loadState) {
     }
 }
 
+void ChunkGroup::setLod(uint32_t lod) {
+    m_lod = lod;
+
+    auto view = m_world->registry().view<Chunk>();
+    for (auto entity : m_chunks) {
+        auto& chunk = view.get<Chunk>(entity);
+        chunk.setLod(lod);
+    }
+}
+
 ChunkGroup* ChunkGroup::getNeighbor(ChunkDirection dir) {
     return m_neighbors[static_cast<size_t>(dir)];
 }
@@ -71,13 +86,27 @@ ChunkDirection ChunkGroup::getDirection(glm::ivec2 offset) {
     }
 }
 
-ChunkManager::ChunkManager(World& world, FreeCam& freeCam, int32_t viewDistance) {
+ChunkManager::ChunkManager(World& world, VoxelEngine::Camera& camera, int32_t viewDistance, const std::array<int32_t, lodLevels>& lodDistances) {
     m_world = &world;
-    m_freeCam = &freeCam;
+    m_camera = &camera;
     m_viewDistance = viewDistance;
     m_viewDistance2 = viewDistance * viewDistance;
 
+    for (size_t i = 0; i < lodLevels; i++) {
+        m_lodDistances2[i] = lodDistances[i] * lodDistances[i];
+    }
+
     m_lastPos = { -1, -1, -1 };
+
+    m_generateRejectedCounter = &VoxelEngine::Metrics::counter("generate.rejected");
+    m_updateRejectedCounter = &VoxelEngine::Metrics::counter("update.rejected");
+    m_meshRejectedCounter = &VoxelEngine::Metrics::counter("mesh.rejected");
+    m_generateQueuedGauge = &VoxelEngine::Metrics::gauge("generate.queued");
+    m_generatePendingGauge = &VoxelEngine::Metrics::gauge("generate.pending");
+    m_updateQueuedGauge = &VoxelEngine::Metrics::gauge("update.queued");
+    m_updatePendingGauge = &VoxelEngine::Metrics::gauge("update.pending");
+    m_meshQueuedGauge = &VoxelEngine::Metrics::gauge("mesh.queued");
+    m_meshPendingGauge = &VoxelEngine::Metrics::gauge("mesh.pending");
 }
 
 void ChunkManager::setTerrainGenerator(TerrainGenerator& terrainGenerator) {
@@ -93,7 +122,7 @@ void ChunkManager::setChunkMesher(ChunkMesher& chunkMesher) {
 }
 
 void ChunkManager::update(VoxelEngine::Clock& clock) {
-    glm::ivec3 worldChunk = Chunk::worldToWorldChunk(m_freeCam->position());
+    glm::ivec3 worldChunk = Chunk::worldToWorldChunk(m_camera->position());
     glm::ivec2 coord = { worldChunk.x, worldChunk.z };
 
     worldChunk.y = std::clamp<int32_t>(worldChunk.y, 0, World::worldHeight);
@@ -131,16 +160,33 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
                 }
             }
         }
+
+        for (auto& pair : m_chunkMap) {
+            updateLod(pair.second, pair.first);
+        }
     }
 
     glm::ivec3 worldChunk2D = worldChunk;
     worldChunk2D.y = 0;
     m_generateQueue.update(worldChunk2D);
 
-    while (m_generateQueue.count() > 0) {
-        auto item = m_generateQueue.peek();
-        if (!m_terrainGenerator->enqueue({ item.x, item.z })) break;
-        m_generateQueue.dequeue();
+    //the workers' queues are only filled from this thread, so their free space can only grow until the batch is submitted
+    size_t generateSpace = m_terrainGenerator->freeCount();
+    m_generateBatch.clear();
+
+    if (generateSpace == 0 && m_generateQueue.count() > 0) {
+        m_generateRejectedCounter->add();
+    }
+
+    while (m_generateQueue.count() > 0 && m_generateBatch.size() < generateSpace) {
+        auto item = m_generateQueue.dequeue();
+        m_generateBatch.push_back({ item.x, item.z });
+    }
+
+    size_t generateAccepted = m_terrainGenerator->enqueueBulk(m_generateBatch);
+
+    for (size_t i = generateAccepted; i < m_generateBatch.size(); i++) {
+        m_generateQueue.enqueue({ m_generateBatch[i].x, 0, m_generateBatch[i].y });
     }
 
     auto& generateResults = m_generateResultQueue.swapDequeue();
@@ -170,17 +216,24 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
 
     m_updateQueue.update(worldChunk);
 
-    while (m_updateQueue.count() > 0) {
-        auto item = m_updateQueue.peek();
-        auto entity = m_world->getEntity(item);
+    size_t updateSpace = m_chunkUpdater->freeCount();
+    m_updateBatch.clear();
 
-        if (entity == entt::null) {
-            m_updateQueue.dequeue();
-            continue;
-        }
+    if (updateSpace == 0 && m_updateQueue.count() > 0) {
+        m_updateRejectedCounter->add();
+    }
+
+    while (m_updateQueue.count() > 0 && m_updateBatch.size() < updateSpace) {
+        auto item = m_updateQueue.dequeue();
+        if (m_world->getEntity(item) == entt::null) continue;
 
-        if (!m_chunkUpdater->queue(item)) break;
-        m_updateQueue.dequeue();
+        m_updateBatch.push_back(item);
+    }
+
+    size_t updateAccepted = m_chunkUpdater->queueBulk(m_updateBatch);
+
+    for (size_t i = updateAccepted; i < m_updateBatch.size(); i++) {
+        m_updateQueue.enqueue(m_updateBatch[i]);
     }
 
     while (m_updateRequeue.size() > 0) {
@@ -200,6 +253,7 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
         auto entity = m_world->getEntity(worldChunkPos);
 
         if (entity == entt::null) {
+            clearEditPending(worldChunkPos);
             updateResults.pop();
             continue;
         }
@@ -212,12 +266,45 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
             chunk.light()[pos] = lightBuffer[pos + glm::ivec3(1, 1, 1)];
         }
 
-        m_meshingQueue.enqueue(worldChunkPos);
+        m_world->updateSnapshot(worldChunkPos);
 
-        for (auto offset : Chunk::Neighbors26) {
-            auto pos = worldChunkPos + offset;
-            if (m_world->valid(pos)) {
-                m_meshingQueue.enqueue(pos);
+        //chunks changed by an edit are held back until the whole edit is updated, so that each one is only meshed once
+        //an update that started before the chunk's latest edit was committed doesn't include it, so the chunk stays pending
+        auto pending = m_editPending.find(worldChunkPos);
+        uint64_t edit = 0;
+        bool completed = false;
+
+        if (pending != m_editPending.end()) {
+            edit = pending->second;
+            completed = update.editGeneration >= edit;
+
+            if (completed) {
+                m_editPending.erase(pending);
+            }
+        }
+
+        if (edit != 0) {
+            auto& group = m_edits[edit];
+            group.meshing.insert(worldChunkPos);
+
+            for (auto offset : Chunk::Neighbors26) {
+                auto pos = worldChunkPos + offset;
+                if (m_world->valid(pos)) {
+                    group.meshing.insert(pos);
+                }
+            }
+
+            if (completed) {
+                releaseEdit(edit);
+            }
+        } else {
+            m_meshingQueue.enqueue(worldChunkPos);
+
+            for (auto offset : Chunk::Neighbors26) {
+                auto pos = worldChunkPos + offset;
+                if (m_world->valid(pos)) {
+                    m_meshingQueue.enqueue(pos);
+                }
             }
         }
 
@@ -226,8 +313,17 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
 
     m_meshingQueue.update(worldChunk);
 
-    while (m_meshingQueue.count() > 0) {
+    size_t meshingSpace = m_chunkMesher->freeCount();
+    m_meshingBatch.clear();
+    m_meshingBiases.clear();
+
+    if (meshingSpace == 0 && m_meshingQueue.count() > 0) {
+        m_meshRejectedCounter->add();
+    }
+
+    while (m_meshingQueue.count() > 0 && m_meshingBatch.size() < meshingSpace) {
         auto item = m_meshingQueue.peek();
+        int32_t bias = m_meshingQueue.bias(item);
         if (!m_world->valid(item)) {
             m_meshingQueue.dequeue();
             continue;
@@ -236,7 +332,7 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
         auto& chunk = view.get<Chunk>(m_world->getEntity(item));
 
         if (chunk.loadState() != ChunkLoadState::Loaded) {
-            m_meshingRequeue.push(item);
+            m_meshingRequeue.push({ item, bias });
             m_meshingQueue.dequeue();
             continue;
         }
@@ -248,7 +344,7 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
             if (neighborEntity != entt::null) {
                 auto& neighborChunk = view.get<Chunk>(neighborEntity);
                 if (neighborChunk.loadState() != ChunkLoadState::Loaded) {
-                    m_meshingRequeue.push(item);
+                    m_meshingRequeue.push({ item, bias });
                     m_meshingQueue.dequeue();
                     skip = true;
                     break;
@@ -260,13 +356,44 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
             continue;
         }
 
-        if (!m_chunkMesher->queue(item)) break;
+        //a column that changed level of detail waits for the neighbors sharing its seam, so their skirts are in place first
+        //neighbors that changed level too are not waited on, the mesher keeps skirts against a neighbor whose mesh is out of date
+        if (m_lodMeshing.count(item) > 0) {
+            for (auto offset : Chunk::Neighbors4) {
+                auto pos = item + offset;
+
+                if (m_seamMeshing.count(pos) > 0 && m_lodMeshing.count(pos) == 0) {
+                    m_meshingRequeue.push({ item, bias });
+                    m_meshingQueue.dequeue();
+                    skip = true;
+                    break;
+                }
+            }
+        }
+
+        if (skip) {
+            continue;
+        }
+
+        m_meshingBatch.push_back(item);
+        m_meshingBiases.push_back(bias);
         m_meshingQueue.dequeue();
     }
 
+    size_t meshingAccepted = m_chunkMesher->queueBulk(m_meshingBatch);
+
+    for (size_t i = 0; i < meshingAccepted; i++) {
+        m_lodMeshing.erase(m_meshingBatch[i]);
+        m_seamMeshing.erase(m_meshingBatch[i]);
+    }
+
+    for (size_t i = meshingAccepted; i < m_meshingBatch.size(); i++) {
+        m_meshingQueue.enqueue(m_meshingBatch[i], m_meshingBiases[i]);
+    }
+
     while (m_meshingRequeue.size() > 0) {
         auto& item = m_meshingRequeue.front();
-        m_meshingQueue.enqueue(item);
+        m_meshingQueue.enqueue(item.first, item.second);
         m_meshingRequeue.pop();
     }
 
@@ -277,12 +404,41 @@ void ChunkManager::update(VoxelEngine::Clock& clock) {
         m_updateQueue.enqueue(update);
         worldChunkUpdates.pop();
     }
+
+    auto& editUpdates = m_world->getEditUpdates();
+
+    while (editUpdates.size() > 0) {
+        auto update = editUpdates.front();
+        auto result = m_editPending.insert({ update.worldChunkPos, update.edit });
+
+        //a chunk changed again before its update finished counts towards the newer edit only
+        if (!result.second) {
+            uint64_t previous = result.first->second;
+            result.first->second = update.edit;
+            releaseEdit(previous);
+        }
+
+        m_edits[update.edit].pending++;
+        m_updateQueue.enqueue(update.worldChunkPos);
+        editUpdates.pop();
+    }
+
+    m_world->publishSnapshot();
+
+    //chunks waiting in the priority queues, and chunks accepted by the workers but not started yet
+    m_generateQueuedGauge->set(m_generateQueue.count());
+    m_generatePendingGauge->set(m_terrainGenerator->pendingCount());
+    m_updateQueuedGauge->set(m_updateQueue.count());
+    m_updatePendingGauge->set(m_chunkUpdater->pendingCount());
+    m_meshQueuedGauge->set(m_meshingQueue.count());
+    m_meshPendingGauge->set(m_chunkMesher->pendingCount());
 }
 
 ChunkGroup& ChunkManager::makeChunkGroup(glm::ivec2 coord) {
     auto result = m_chunkMap.emplace(coord, ChunkGroup(coord, *m_world));
     ChunkGroup& group = result.first->second;
     group.setLoadState(ChunkLoadState::Loading);
+    group.setLod(getLod(coord));
 
     for (auto offset : Chunk::Neighbors8_2D) {
         ChunkDirection dir = ChunkGroup::getDirection(offset);
@@ -356,11 +512,77 @@ ChunkManager::ChunkMap::iterator ChunkManager::destroyChunkGroup(ChunkMap::itera
 
     for (int32_t i = 0; i < worldHeight; i++) {
         m_meshingQueue.remove({ coord.x, i, coord.y });
+        clearEditPending({ coord.x, i, coord.y });
+        m_lodMeshing.erase({ coord.x, i, coord.y });
+        m_seamMeshing.erase({ coord.x, i, coord.y });
     }
 
     return m_chunkMap.erase(it);
 }
 
+uint32_t ChunkManager::getLod(glm::ivec2 coord) const {
+    int32_t dist2 = distance2(coord, { m_lastPos.x, m_lastPos.z });
+    uint32_t lod = 0;
+
+    while (lod < lodLevels && dist2 > m_lodDistances2[lod]) {
+        lod++;
+    }
+
+    return lod;
+}
+
+void ChunkManager::updateLod(ChunkGroup& group, glm::ivec2 coord) {
+    uint32_t lod = getLod(coord);
+    if (lod == group.lod()) return;
+
+    //refining columns moving towards the camera is more urgent than coarsening columns moving away from it
+    int32_t bias = lod < group.lod() ? 0 : m_viewDistance2;
+    group.setLod(lod);
+
+    //neighbors are remeshed too, since the skirts along the shared side depend on both levels
+    //they are meshed before the column itself, so the seam always has skirts on at least the side that needs them
+    for (int32_t i = 0; i < World::worldHeight; i++) {
+        glm::ivec3 chunkPos = { coord.x, i, coord.y };
+        m_meshingQueue.enqueue(chunkPos, bias);
+        m_lodMeshing.insert(chunkPos);
+
+        for (auto offset : Chunk::Neighbors4) {
+            glm::ivec3 pos = chunkPos + offset;
+
+            if (m_world->valid(pos)) {
+                m_meshingQueue.enqueue(pos, bias);
+                m_seamMeshing.insert(pos);
+            }
+        }
+    }
+}
+
+void ChunkManager::clearEditPending(glm::ivec3 worldChunkPos) {
+    auto it = m_editPending.find(worldChunkPos);
+    if (it == m_editPending.end()) return;
+
+    uint64_t edit = it->second;
+    m_editPending.erase(it);
+    releaseEdit(edit);
+}
+
+void ChunkManager::releaseEdit(uint64_t edit) {
+    auto it = m_edits.find(edit);
+    if (it == m_edits.end()) return;
+
+    auto& group = it->second;
+    group.pending--;
+    if (group.pending > 0) return;
+
+    for (auto pos : group.meshing) {
+        if (m_world->valid(pos)) {
+            m_meshingQueue.enqueue(pos);
+        }
+    }
+
+    m_edits.erase(it);
+}
+
 int32_t ChunkManager::distance2(glm::ivec2 a, glm::ivec2 b) {
     glm::ivec2 diff = a - b;
     return (diff.x * diff.x) + (diff.y * diff.y);
@@ -2,11 +2,13 @@
 #include <entt/entt.hpp>
 #include <Engine/System.h>
 #include <Engine/BufferedQueue.h>
+#include <Engine/Metrics.h>
 #include <unordered_map>
+#include <unordered_set>
 #include <queue>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
-#include "FreeCam.h"
+#include <Engine/Camera.h>
 #include "Chunk.h"
 #include "World.h"
 #include "PriorityQueue.h"
@@ -31,6 +33,9 @@ public:
     ChunkLoadState loadState() const { return m_loadState; }
     void setLoadState(ChunkLoadState loadState);
 
+    uint32_t lod() const { return m_lod; }
+    void setLod(uint32_t lod);
+
     ChunkGroup* getNeighbor(ChunkDirection dir);
     ChunkGroup* getNeighbor(glm::ivec2 offset);
     ChunkGroup* getNeighbor(glm::ivec3 offset);
@@ -41,6 +46,7 @@ public:
 
 private:
     ChunkLoadState m_loadState;
+    uint32_t m_lod;
     glm::ivec2 m_coord;
     World* m_world;
     std::vector<entt::entity> m_chunks;
@@ -51,8 +57,12 @@ private:
 class ChunkManager : public VoxelEngine::System {
 public:
     static const int32_t worldHeight = 16;
+    static const uint32_t lodLevels = 3;
+
+    //columns further than lodDistances[i] are meshed at level i + 1
+    ChunkManager(World& world, VoxelEngine::Camera& camera, int32_t viewDistance, const std::array<int32_t, lodLevels>& lodDistances);
 
-    ChunkManager(World& world, FreeCam& freeCam, int32_t viewDistance);
+    int32_t viewDistance() const { return m_viewDistance; }
 
     void setTerrainGenerator(TerrainGenerator& terrainGenerator);
     void setChunkUpdater(ChunkUpdater& chunkUpdater);
@@ -66,7 +76,7 @@ public:
 private:
     using ChunkMap = std::unordered_map<glm::ivec2, ChunkGroup>;
     World* m_world;
-    FreeCam* m_freeCam;
+    VoxelEngine::Camera* m_camera;
     TerrainGenerator* m_terrainGenerator;
     ChunkUpdater* m_chunkUpdater;
     ChunkMesher* m_chunkMesher;
@@ -74,6 +84,7 @@ private:
     ChunkMap m_chunkMap;
     int32_t m_viewDistance;
     int32_t m_viewDistance2;
+    std::array<int32_t, lodLevels> m_lodDistances2;
 
     PriorityQueue m_generateQueue;
     VoxelEngine::BufferedQueue<TerrainResults> m_generateResultQueue;
@@ -81,9 +92,37 @@ private:
     VoxelEngine::BufferedQueue<UpdateResults> m_updateResultQueue;
     std::queue<glm::ivec3> m_updateRequeue;
     PriorityQueue m_meshingQueue;
-    std::queue<glm::ivec3> m_meshingRequeue;
+    std::queue<std::pair<glm::ivec3, int32_t>> m_meshingRequeue;
+    std::unordered_set<glm::ivec3> m_lodMeshing;
+    std::unordered_set<glm::ivec3> m_seamMeshing;
+    //chunks changed by an edit are meshed together once every chunk in the edit is updated
+    struct EditGroup {
+        size_t pending;
+        std::unordered_set<glm::ivec3> meshing;
+    };
+
+    std::unordered_map<glm::ivec3, uint64_t> m_editPending;
+    std::unordered_map<uint64_t, EditGroup> m_edits;
+    std::vector<glm::ivec2> m_generateBatch;
+    std::vector<glm::ivec3> m_updateBatch;
+    std::vector<glm::ivec3> m_meshingBatch;
+    std::vector<int32_t> m_meshingBiases;
+
+    VoxelEngine::Counter* m_generateRejectedCounter;
+    VoxelEngine::Counter* m_updateRejectedCounter;
+    VoxelEngine::Counter* m_meshRejectedCounter;
+    VoxelEngine::Gauge* m_generateQueuedGauge;
+    VoxelEngine::Gauge* m_generatePendingGauge;
+    VoxelEngine::Gauge* m_updateQueuedGauge;
+    VoxelEngine::Gauge* m_updatePendingGauge;
+    VoxelEngine::Gauge* m_meshQueuedGauge;
+    VoxelEngine::Gauge* m_meshPendingGauge;
 
     ChunkGroup& makeChunkGroup(glm::ivec2 coord);
     ChunkMap::iterator destroyChunkGroup(ChunkMap::iterator it, glm::ivec2 coord);
+    uint32_t getLod(glm::ivec2 coord) const;
+    void updateLod(ChunkGroup& group, glm::ivec2 coord);
+    void clearEditPending(glm::ivec3 worldChunkPos);
+    void releaseEdit(uint64_t edit);
     static int32_t distance2(glm::ivec2 a, glm::ivec2 b);
 };
\ No newline at end of file
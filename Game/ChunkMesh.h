@@ -1,6 +1,7 @@
 #pragma once
 #include <Engine/Engine.h>
 #include <memory>
+#include <array>
 
 #include "MeshManager.h"
 
@@ -21,6 +22,10 @@ public:
 
     void clearMesh();
 
+    //number of faces in each Chunk::Neighbors6 direction, stored in that order
+    const std::array<uint32_t, 6>& faceCounts() const { return m_faceCounts; }
+    void setFaceCounts(const std::array<uint32_t, 6>& faceCounts) { m_faceCounts = faceCounts; }
+
     int32_t vertexOffset() const { return m_mesh.vertexOffset(); }
     void setVertexOffset(int32_t vertexOffset) { m_mesh.setVertexOffset(vertexOffset); }
 
@@ -33,6 +38,7 @@ public:
 private:
     VoxelEngine::Mesh m_mesh;
     bool m_dirty = false;
+    std::array<uint32_t, 6> m_faceCounts = {};
 
     std::vector<MeshAllocation> m_allocations;
 };
\ No newline at end of file
@@ -6,6 +6,13 @@ ChunkMesher::ChunkMesher(VoxelEngine::Engine& engine, World& world, BlockManager
     m_world = &world;
     m_blockManager = &blockManager;
     m_meshManager = &meshManager;
+    m_transferNode = nullptr;
+
+    m_meshWaitHistogram = &VoxelEngine::Metrics::histogram("mesh.wait");
+    m_meshServiceHistogram = &VoxelEngine::Metrics::histogram("mesh.service");
+    m_meshCompletedCounter = &VoxelEngine::Metrics::counter("mesh.completed");
+    m_chunkReadyHistogram = &VoxelEngine::Metrics::histogram("chunk.ready");
+    m_meshTransferHistogram = &VoxelEngine::Metrics::histogram("mesh.transfer");
 }
 
 void ChunkMesher::setTransferNode(VoxelEngine::TransferNode& transferNode) {
@@ -37,25 +44,50 @@ void ChunkMesher::stop() {
 }
 
 bool ChunkMesher::queue(glm::ivec3 coord) {
-    return m_requestQueue.tryEnqueue(coord);
+    return m_requestQueue.tryEnqueue({ coord, VoxelEngine::Metrics::now() });
+}
+
+size_t ChunkMesher::queueBulk(const std::vector<glm::ivec3>& coords) {
+    uint64_t time = VoxelEngine::Metrics::now();
+    m_bulkRequests.clear();
+
+    for (auto coord : coords) {
+        m_bulkRequests.push_back({ coord, time });
+    }
+
+    return m_requestQueue.tryEnqueueBulk(m_bulkRequests.data(), m_bulkRequests.size());
 }
 
 void ChunkMesher::loop() {
+    VOXEL_PROFILE_THREAD("ChunkMesher");
+
+    std::vector<Request> requests;
+
     while (m_running) {
-        glm::ivec3 coord;
-        bool valid = m_requestQueue.dequeue(coord);
-        if (!valid) return;
+        requests.clear();
+        if (!m_requestQueue.dequeueUpTo(requests, batchSize)) return;
+
+        for (auto& request : requests) {
+            uint64_t start = VoxelEngine::Metrics::now();
+            m_meshWaitHistogram->record(start - request.time);
 
-        update(coord);
+            update(request.coord);
+
+            m_meshServiceHistogram->record(VoxelEngine::Metrics::now() - start);
+            m_meshCompletedCounter->add();
+        }
     }
 }
 
 void ChunkMesher::update(glm::ivec3 worldChunkPos) {
+    VOXEL_PROFILE_SCOPE("ChunkMesher::update");
     ChunkBuffer blocks;
     LightBuffer light;
     ChunkData<Chunk*, 3> neighborChunks;
     const glm::ivec3 root = { 1, 1, 1 };
     std::queue<LightUpdate> queue;
+    uint32_t lod = 0;
+    uint32_t skirts = 0;
 
     {
         auto lock = m_world->getLock();
@@ -64,6 +96,23 @@ void ChunkMesher::update(glm::ivec3 worldChunkPos) {
 
         auto view = m_world->registry().view<Chunk>();
         Chunk& chunk = view.get<Chunk>(entity);
+        lod = chunk.lod();
+
+        chunk.setMeshLod(lod);
+
+        //faces on a side shared with a column of a different level of detail are kept, to hide cracks in the seam
+        //a neighbor whose mesh has not caught up with its level yet counts as different
+        for (size_t i = 0; i < Chunk::Neighbors6.size(); i++) {
+            entt::entity neighborEntity = chunk.neighbor(Chunk::Neighbors6[i]);
+
+            if (m_world->valid(neighborEntity)) {
+                auto& neighbor = view.get<Chunk>(neighborEntity);
+
+                if (neighbor.lod() != lod || neighbor.meshLod() != lod) {
+                    skirts |= 1 << i;
+                }
+            }
+        }
 
         for (auto offset : Chunk::Neighbors26) {
             entt::entity neighborEntity = chunk.neighbor(offset);
@@ -111,34 +160,89 @@ void ChunkMesher::update(glm::ivec3 worldChunkPos) {
         }
     }
 
-    size_t updateIndex = makeMesh(worldChunkPos, blocks, light);
+    size_t updateIndex = makeMesh(worldChunkPos, blocks, light, lod, skirts);
     m_resultQueue.enqueue({ updateIndex, worldChunkPos, light });
 }
 
-size_t ChunkMesher::makeMesh(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer) {
+size_t ChunkMesher::makeMesh(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t lod, uint32_t skirts) {
+    VOXEL_PROFILE_SCOPE("ChunkMesher::makeMesh");
     size_t index = m_updateIndex;
-    m_updateIndex = (m_updateIndex + 1) % (queueSize * 2);
+    m_updateIndex = (m_updateIndex + 1) % m_updates.size();
 
     MeshUpdate& update = m_updates[index];
-    update.vertexData.clear();
+    update.faceData.clear();
 
-    uint32_t indexCount = 0;
-    const glm::ivec3 root = { 1, 1, 1 };
+    for (auto& faces : m_faces) {
+        faces.clear();
+    }
 
-    auto view = m_world->registry().view<Chunk>();
+    if (lod == 0) {
+        makeFaces(worldChunkPos, chunkBuffer, lightBuffer, skirts);
+    } else {
+        makeLodFaces(worldChunkPos, chunkBuffer, lightBuffer, lod, skirts);
+    }
+
+    //faces are grouped by direction, so that ChunkRenderer can skip groups that face away from the camera
+    for (size_t i = 0; i < m_faces.size(); i++) {
+        update.faceCounts[i] = static_cast<uint32_t>(m_faces[i].size());
+        update.faceData.insert(update.faceData.end(), m_faces[i].begin(), m_faces[i].end());
+    }
+
+    update.faceCount = static_cast<uint32_t>(update.faceData.size());
+    update.connectivity = findConnectivity(chunkBuffer);
+
+    return index;
+}
+
+void ChunkMesher::makeFaces(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t skirts) {
+    const glm::ivec3 root = { 1, 1, 1 };
+    const int32_t worldHeightMin = 0;
+    const int32_t worldHeightMax = World::worldHeight * Chunk::chunkSize;
+    const int32_t size = Chunk::chunkSize + 2;
+
+    auto rowIndex = [size](int32_t y, int32_t z) {
+        return y + (z * size);
+    };
+
+    //the rows are contiguous in the buffer, so each row's flags are looked up with one mask call
+    for (int32_t z = 0; z < size; z++) {
+        for (int32_t y = 0; y < size; y++) {
+            const Block* row = &chunkBuffer[glm::ivec3(0, y, z)];
+            m_opaqueRows[rowIndex(y, z)] = m_blockManager->opaqueMask(row, size);
+            m_visibleRows[rowIndex(y, z)] = m_blockManager->visibleMask(row, size);
+        }
+    }
 
     for (glm::ivec3 pos : Chunk::Positions()) {
-        Block block = chunkBuffer[root + pos];
-        if (block.type == 0) continue;
-        if (block.type == 1) continue;
-        BlockType& blockType = m_blockManager->getType(block.type);
+        glm::ivec3 bufferPos = root + pos;
+        uint32_t bit = 1u << bufferPos.x;
+        uint32_t row = m_opaqueRows[rowIndex(bufferPos.y, bufferPos.z)];
+        if ((m_visibleRows[rowIndex(bufferPos.y, bufferPos.z)] & bit) == 0) continue;
+
+        //in the order of Chunk::Neighbors6
+        std::array<bool, 6> neighborOpaque = {
+            (row & (bit << 1)) != 0,
+            (row & (bit >> 1)) != 0,
+            (m_opaqueRows[rowIndex(bufferPos.y + 1, bufferPos.z)] & bit) != 0,
+            (m_opaqueRows[rowIndex(bufferPos.y - 1, bufferPos.z)] & bit) != 0,
+            (m_opaqueRows[rowIndex(bufferPos.y, bufferPos.z + 1)] & bit) != 0,
+            (m_opaqueRows[rowIndex(bufferPos.y, bufferPos.z - 1)] & bit) != 0
+        };
+
+        bool exposed = false;
+        for (auto opaque : neighborOpaque) {
+            exposed |= !opaque;
+        }
+
+        //a buried block has no faces unless it is at the top or bottom of the world
+        int32_t worldY = pos.y + (worldChunkPos.y * Chunk::chunkSize);
+        if (!exposed && worldY != worldHeightMin && worldY != worldHeightMax - 1) continue;
 
-        ChunkData<Block, 3> neighborBlocks;
+        Block block = chunkBuffer[bufferPos];
         ChunkData<Light, 3> neighborLight;
 
         for (auto offset : Chunk::Neighbors26) {
-            neighborBlocks[root + offset] = chunkBuffer[root + pos + offset];
-            neighborLight[root + offset] = lightBuffer[root + pos + offset];
+            neighborLight[root + offset] = lightBuffer[bufferPos + offset];
         }
 
         for (size_t i = 0; i < Chunk::Neighbors6.size(); i++) {
@@ -146,51 +250,223 @@ size_t ChunkMesher::makeMesh(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer,
             glm::ivec3 neighborPos = pos + offset;
             glm::ivec3 worldNeighborPos = neighborPos + (worldChunkPos * Chunk::chunkSize);
 
-            const int32_t worldHeightMin = 0;
-            const int32_t worldHeightMax = World::worldHeight * Chunk::chunkSize;
+            bool visible = !neighborOpaque[i] || worldNeighborPos.y >= worldHeightMax || worldNeighborPos.y < worldHeightMin;
+            bool skirt = (skirts & (1 << i)) != 0 && exposed && !Chunk::chunkPosInBounds(neighborPos);
 
-            bool visible = neighborBlocks[root + offset].type == 1 || worldNeighborPos.y >= worldHeightMax || worldNeighborPos.y < worldHeightMin;
-
-            if (visible) {
+            if (visible || skirt) {
                 const Chunk::FaceData& faceData = Chunk::NeighborFaces[i];
-                size_t faceIndex = blockType.getFaceIndex(i);
+                uint32_t faceIndex = m_blockManager->faceLayer(block, i);
+                uint32_t cornerLight = 0;
 
                 for (size_t j = 0; j < faceData.vertices.size(); j++) {
-                    int32_t light = neighborLight[root + offset].sun;
+                    int32_t sun = neighborLight[root + offset].sun();
+                    int32_t blockLight = neighborLight[root + offset].block();
 
                     for (size_t k = 0; k < 3; k++) {
-                        light += neighborLight[root + faceData.ambientOcclusion[j][k]].sun;
+                        sun += neighborLight[root + faceData.ambientOcclusion[j][k]].sun();
+                        blockLight += neighborLight[root + faceData.ambientOcclusion[j][k]].block();
                     }
 
-                    light /= 4;
-                    light = std::max(light * 17, 0);
+                    cornerLight |= static_cast<uint32_t>(sun / 4) << (j * 4);
+                    cornerLight |= static_cast<uint32_t>(blockLight / 4) << (16 + (j * 4));
+                }
 
-                    ChunkVertex vertex = {
-                        glm::i8vec4(pos + faceData.vertices[j], 0),
-                        glm::i8vec4(light, light, light, 0),
-                        glm::i8vec4(Chunk::uvFaces[j], static_cast<uint8_t>(faceIndex), 0)
-                    };
+                m_faces[i].emplace_back(pos, static_cast<uint32_t>(i), faceIndex, cornerLight);
+            }
+        }
+    }
+}
 
-                    update.vertexData.push_back(vertex);
+void ChunkMesher::makeLodFaces(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t lod, uint32_t skirts) {
+    const glm::ivec3 root = { 1, 1, 1 };
+    const int32_t worldHeightMin = 0;
+    const int32_t worldHeightMax = World::worldHeight * Chunk::chunkSize;
+    const int32_t scale = 1 << lod;
+    const int32_t cells = Chunk::chunkSize >> lod;
+    const int32_t size = cells + 2;
+
+    auto cellIndex = [size](glm::ivec3 cell) {
+        return (cell.x + 1) + ((cell.y + 1) * size) + ((cell.z + 1) * size * size);
+    };
+
+    //downsample the chunk to one block per cell, with a border of cells taken from the single layer of neighbor blocks
+    m_lodBlocks.resize(size * size * size);
+
+    for (int32_t x = -1; x <= cells; x++) {
+        for (int32_t y = -1; y <= cells; y++) {
+            for (int32_t z = -1; z <= cells; z++) {
+                glm::ivec3 cell = { x, y, z };
+                glm::ivec3 min;
+                glm::ivec3 max;
+
+                for (int32_t i = 0; i < 3; i++) {
+                    if (cell[i] < 0) {
+                        min[i] = -1;
+                        max[i] = -1;
+                    } else if (cell[i] == cells) {
+                        min[i] = Chunk::chunkSize;
+                        max[i] = Chunk::chunkSize;
+                    } else {
+                        min[i] = cell[i] * scale;
+                        max[i] = min[i] + scale - 1;
+                    }
                 }
 
-                indexCount++;
+                m_lodBlocks[cellIndex(cell)] = downsample(chunkBuffer, min, max);
             }
         }
     }
 
-    update.indexCount = indexCount * 6;
+    for (int32_t x = 0; x < cells; x++) {
+        for (int32_t y = 0; y < cells; y++) {
+            for (int32_t z = 0; z < cells; z++) {
+                glm::ivec3 cell = { x, y, z };
+                Block block = m_lodBlocks[cellIndex(cell)];
+                if (!m_blockManager->visible(block)) continue;
 
-    return index;
+                bool exposed = false;
+                for (auto offset : Chunk::Neighbors6) {
+                    exposed |= !m_blockManager->opaque(m_lodBlocks[cellIndex(cell + offset)]);
+                }
+
+                glm::ivec3 pos = cell * scale;
+
+                for (size_t i = 0; i < Chunk::Neighbors6.size(); i++) {
+                    glm::ivec3 offset = Chunk::Neighbors6[i];
+                    glm::ivec3 neighborCell = cell + offset;
+                    glm::ivec3 worldNeighborPos = (neighborCell * scale) + (worldChunkPos * Chunk::chunkSize);
+                    bool border = neighborCell.x < 0 || neighborCell.y < 0 || neighborCell.z < 0 || neighborCell.x == cells || neighborCell.y == cells || neighborCell.z == cells;
+
+                    bool visible = !m_blockManager->opaque(m_lodBlocks[cellIndex(neighborCell)]) || worldNeighborPos.y >= worldHeightMax || worldNeighborPos.y < worldHeightMin;
+                    bool skirt = (skirts & (1 << i)) != 0 && exposed && border;
+
+                    if (!visible && !skirt) continue;
+
+                    //light is sampled from the block just outside the middle of the face, there is no ambient occlusion at lower detail
+                    glm::ivec3 lightPos = pos + glm::ivec3(scale / 2);
+                    for (int32_t j = 0; j < 3; j++) {
+                        if (offset[j] > 0) lightPos[j] = pos[j] + scale;
+                        if (offset[j] < 0) lightPos[j] = pos[j] - 1;
+                    }
+
+                    Light light = lightBuffer[root + lightPos];
+                    uint32_t cornerLight = (static_cast<uint32_t>(light.sun()) * 0x1111) | (static_cast<uint32_t>(light.block()) * 0x11110000);
+
+                    m_faces[i].emplace_back(pos, static_cast<uint32_t>(i), m_blockManager->faceLayer(block, i), cornerLight, lod);
+                }
+            }
+        }
+    }
+}
+
+Block ChunkMesher::downsample(ChunkBuffer& chunkBuffer, glm::ivec3 min, glm::ivec3 max) {
+    //majority vote decides if the cell is filled, the highest block in the cell decides its type so that surfaces keep their top layer
+    const glm::ivec3 root = { 1, 1, 1 };
+    int32_t filled = 0;
+    int32_t total = 0;
+    Block top = Block(0);
+    int32_t topY = min.y - 1;
+
+    for (int32_t x = min.x; x <= max.x; x++) {
+        for (int32_t y = min.y; y <= max.y; y++) {
+            for (int32_t z = min.z; z <= max.z; z++) {
+                Block block = chunkBuffer[root + glm::ivec3(x, y, z)];
+                total++;
+
+                if (!m_blockManager->opaque(block)) continue;
+                filled++;
+
+                if (m_blockManager->visible(block) && y > topY) {
+                    top = block;
+                    topY = y;
+                }
+            }
+        }
+    }
+
+    if (filled * 2 < total) {
+        return World::airBlock();
+    }
+
+    return top;
+}
+
+uint16_t ChunkMesher::findConnectivity(ChunkBuffer& chunkBuffer) {
+    //flood fill every region of non-solid blocks and record which faces of the chunk it touches
+    const glm::ivec3 root = { 1, 1, 1 };
+    const int32_t max = Chunk::chunkSize - 1;
+    std::array<bool, Chunk::chunkSize * Chunk::chunkSize * Chunk::chunkSize> visited = {};
+    uint16_t connectivity = 0;
+
+    for (glm::ivec3 start : Chunk::Positions()) {
+        size_t startIndex = Chunk::index(start);
+        if (visited[startIndex]) continue;
+        if (m_blockManager->opaque(chunkBuffer[root + start])) continue;
+
+        uint32_t faces = 0;
+        visited[startIndex] = true;
+        m_fillStack.push_back(static_cast<uint16_t>(startIndex));
+
+        while (m_fillStack.size() > 0) {
+            glm::ivec3 pos = Chunk::position(m_fillStack.back());
+            m_fillStack.pop_back();
+
+            //same order as Chunk::Neighbors6
+            if (pos.x == max) faces |= 1 << 0;
+            if (pos.x == 0) faces |= 1 << 1;
+            if (pos.y == max) faces |= 1 << 2;
+            if (pos.y == 0) faces |= 1 << 3;
+            if (pos.z == max) faces |= 1 << 4;
+            if (pos.z == 0) faces |= 1 << 5;
+
+            for (auto offset : Chunk::Neighbors6) {
+                glm::ivec3 neighborPos = pos + offset;
+                if (!Chunk::chunkPosInBounds(neighborPos)) continue;
+
+                size_t neighborIndex = Chunk::index(neighborPos);
+                if (visited[neighborIndex]) continue;
+                visited[neighborIndex] = true;
+
+                if (m_blockManager->opaque(chunkBuffer[root + neighborPos])) continue;
+                m_fillStack.push_back(static_cast<uint16_t>(neighborIndex));
+            }
+        }
+
+        for (size_t i = 0; i < 6; i++) {
+            if ((faces & (1 << i)) == 0) continue;
+
+            for (size_t j = i + 1; j < 6; j++) {
+                if ((faces & (1 << j)) == 0) continue;
+                connectivity |= Chunk::connectionBit(i, j);
+            }
+        }
+
+        if (connectivity == Chunk::allConnected) break;
+    }
+
+    return connectivity;
 }
 
 void ChunkMesher::transferMesh(entt::entity entity, size_t index) {
     MeshUpdate& update = m_updates[index];
+    uint64_t start = VoxelEngine::Metrics::now();
+
+    Chunk& chunk = m_world->registry().get<Chunk>(entity);
+    chunk.setConnectivity(update.connectivity);
 
-    if (update.indexCount == 0) {
+    //end to end time from the column being created to the chunk's first mesh
+    if (chunk.loadStart() != 0) {
+        m_chunkReadyHistogram->record(start - chunk.loadStart());
+        chunk.setLoadStart(0);
+    }
+
+    //without a transfer node nothing is drawn, so only the connectivity is kept
+    if (update.faceCount == 0 || m_transferNode == nullptr) {
         if (m_world->registry().has<ChunkMesh>(entity)) {
             m_world->registry().remove<ChunkMesh>(entity);
         }
+
+        m_world->setChunkMeshed(chunk.worldChunkPosition(), entity, false);
         return;
     }
 
@@ -203,25 +479,26 @@ void ChunkMesher::transferMesh(entt::entity entity, size_t index) {
     }
 
     ChunkMesh& chunkMesh = *chunkMeshPtr;
+    m_world->setChunkMeshed(chunk.worldChunkPosition(), entity, true);
 
-    chunkMesh.mesh().setIndexCount(update.indexCount);
-
-    size_t vertexSize = update.vertexData.size() * sizeof(ChunkVertex);
+    //the vertex shader expands every face into two triangles
+    chunkMesh.mesh().setVertexCount(update.faceCount * 6);
+    chunkMesh.setFaceCounts(update.faceCounts);
 
-    if (chunkMesh.mesh().bindingCount() == 0 || chunkMesh.mesh().getBinding(0)->size() != vertexSize) {
-        auto vertexBuffer = m_meshManager->allocateBuffer(vertexSize, sizeof(glm::i8vec4));
+    size_t faceSize = update.faceData.size() * sizeof(ChunkFace);
 
-        chunkMesh.setVertexOffset(vertexBuffer.allocation.offset);
+    if (chunkMesh.mesh().bindingCount() == 0 || chunkMesh.getBinding(0).allocation.size != faceSize) {
+        auto faceBuffer = m_meshManager->allocateBuffer(faceSize, sizeof(ChunkFace));
 
         chunkMesh.clearBindings();
-        chunkMesh.addBinding(std::move(vertexBuffer), sizeof(ChunkVertex));
-
-        chunkMesh.setIndexBuffer(m_meshManager->indexBuffer());
+        chunkMesh.addBinding(std::move(faceBuffer), sizeof(ChunkFace));
     }
 
-    auto& vertexBuffer = chunkMesh.getBinding(0);
+    auto& faceBuffer = chunkMesh.getBinding(0);
 
-    m_transferNode->transfer(*vertexBuffer.buffer, vertexSize, vertexBuffer.allocation.offset, update.vertexData.data());
+    m_transferNode->transfer(*faceBuffer.buffer, faceSize, faceBuffer.allocation.offset, update.faceData.data());
 
     chunkMesh.setDirty();
+
+    m_meshTransferHistogram->record(VoxelEngine::Metrics::now() - start);
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include <Engine/Engine.h>
 #include <Engine/RenderGraph/TransferNode.h>
 #include <Engine/BlockingQueue.h>
+#include <Engine/Metrics.h>
 #include <Engine/BufferedQueue.h>
 #include <entt/entt.hpp>
 #include "Chunk.h"
@@ -8,15 +9,34 @@
 #include "World.h"
 #include "MeshManager.h"
 
-struct ChunkVertex {
-    glm::i8vec4 posData;
-    glm::i8vec4 colorData;
-    glm::i8vec4 uvData;
+//one record per face, shader.vert expands each face into 6 vertices
+//data bits 0-14: block position, 5 bits per axis
+//data bits 15-17: face direction, index into Chunk::Neighbors6
+//data bits 18-19: level of detail, the face covers 2^lod blocks on each side
+//data bits 20-31: texture layer
+//light bits 0-15: sun light, 4 bits per corner, in the order of Chunk::NeighborFaces
+//light bits 16-31: block light, same layout
+struct ChunkFace {
+    uint32_t data;
+    uint32_t light;
+
+    ChunkFace() : data(0), light(0) {}
+    ChunkFace(glm::ivec3 pos, uint32_t face, uint32_t layer, uint32_t light, uint32_t lod = 0) {
+        data = static_cast<uint32_t>(pos.x)
+            | (static_cast<uint32_t>(pos.y) << 5)
+            | (static_cast<uint32_t>(pos.z) << 10)
+            | (face << 15)
+            | (lod << 18)
+            | (layer << 20);
+        this->light = light;
+    }
 };
 
 struct MeshUpdate {
-    std::vector<ChunkVertex> vertexData;
-    uint32_t indexCount;
+    std::vector<ChunkFace> faceData;
+    uint32_t faceCount;
+    std::array<uint32_t, 6> faceCounts;
+    uint16_t connectivity;
 };
 
 struct MeshUpdate2 {
@@ -27,6 +47,7 @@ struct MeshUpdate2 {
 
 class ChunkMesher : public VoxelEngine::System {
     static const size_t queueSize = 16;
+    static const size_t batchSize = 4;
 public:
     ChunkMesher(VoxelEngine::Engine& engine, World& world, BlockManager& blockManager, MeshManager& meshManager);
 
@@ -34,12 +55,22 @@ public:
 
     void update(VoxelEngine::Clock& clock);
 
+    std::thread& thread() { return m_thread; }
+
     void run();
     void stop();
 
     bool queue(glm::ivec3 coord);
+    size_t queueBulk(const std::vector<glm::ivec3>& coords);
+    size_t pendingCount() const { return m_requestQueue.size(); }
+    size_t freeCount() const { return queueSize - m_requestQueue.size(); }
 
 private:
+    struct Request {
+        glm::ivec3 coord;
+        uint64_t time;
+    };
+
     using ChunkBuffer = ChunkData<Block, Chunk::chunkSize + 2>;
     using LightBuffer = ChunkData<Light, Chunk::chunkSize + 2>;
 
@@ -49,15 +80,33 @@ private:
     BlockManager* m_blockManager;
     MeshManager* m_meshManager;
 
-    bool m_running = false;
+    std::atomic<bool> m_running = false;
     std::thread m_thread;
 
-    std::array<MeshUpdate, queueSize * 2> m_updates;
+    VoxelEngine::Histogram* m_meshWaitHistogram;
+    VoxelEngine::Histogram* m_meshServiceHistogram;
+    VoxelEngine::Counter* m_meshCompletedCounter;
+    VoxelEngine::Histogram* m_chunkReadyHistogram;
+    VoxelEngine::Histogram* m_meshTransferHistogram;
+
+    std::array<MeshUpdate, (queueSize + batchSize) * 2> m_updates;
     size_t m_updateIndex = 0;
-    VoxelEngine::BlockingQueue<glm::ivec3> m_requestQueue;
+    VoxelEngine::BlockingQueue<Request> m_requestQueue;
+    std::vector<Request> m_bulkRequests;
     VoxelEngine::BufferedQueue<MeshUpdate2> m_resultQueue;
 
-    size_t makeMesh(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer);
+    std::vector<uint16_t> m_fillStack;
+    std::array<std::vector<ChunkFace>, 6> m_faces;
+    std::vector<Block> m_lodBlocks;
+    //one mask per row of the padded chunk buffer along x, bit x is the block at x in the buffer
+    std::array<uint32_t, (Chunk::chunkSize + 2) * (Chunk::chunkSize + 2)> m_opaqueRows;
+    std::array<uint32_t, (Chunk::chunkSize + 2) * (Chunk::chunkSize + 2)> m_visibleRows;
+
+    size_t makeMesh(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t lod, uint32_t skirts);
+    void makeFaces(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t skirts);
+    void makeLodFaces(glm::ivec3 worldChunkPos, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, uint32_t lod, uint32_t skirts);
+    Block downsample(ChunkBuffer& chunkBuffer, glm::ivec3 min, glm::ivec3 max);
+    uint16_t findConnectivity(ChunkBuffer& chunkBuffer);
     void transferMesh(entt::entity entity, size_t index);
 
     void update(glm::ivec3 worldChunkPos);
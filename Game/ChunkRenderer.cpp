@@ -4,9 +4,12 @@
 #include "ChunkMesh.h"
 #include "ChunkMesher.h"
 #include <Engine/Utilities.h>
+#include <Engine/Metrics.h>
+#include <algorithm>
 
-ChunkRenderer::ChunkRenderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::AcquireNode& acquireNode, VoxelEngine::TransferNode& transferNode, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, MeshManager& meshManager)
+ChunkRenderer::ChunkRenderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::AcquireNode& acquireNode, VoxelEngine::TransferNode& transferNode, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, FarTerrain& farTerrain, MeshManager& meshManager)
     : VoxelEngine::RenderGraph::Node(graph, *engine.getGraphics().graphicsQueue(), vk::PipelineStageFlags::ColorAttachmentOutput) {
+    setName("ChunkRenderer");
     m_engine = &engine;
     m_graphics = &engine.getGraphics();
     m_acquireNode = &acquireNode;
@@ -16,21 +19,39 @@ ChunkRenderer::ChunkRenderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGra
     m_textureManager = &textureManager;
     m_skyboxManager = &skyboxManager;
     m_selectionBox = &selectionBox;
+    m_farTerrain = &farTerrain;
     m_meshManager = &meshManager;
 
+    auto& enabledFeatures = m_graphics->enabledFeatures().features;
+    m_indirectSupported = enabledFeatures.multiDrawIndirect && enabledFeatures.drawIndirectFirstInstance;
+    m_compactDraws = m_indirectSupported && m_graphics->enabledFeatures().features12.drawIndirectCount;
+    m_depthPrepass = false;
+    m_droppedDraws = 0;
+    m_droppedDrawsCounter = &VoxelEngine::Metrics::counter("render.droppedDraws");
+
     createDepthBuffer();
     createRenderPass();
     createFramebuffers();
+    createDrawBuffers();
+    createDrawDescriptorSetLayout();
+    createDrawDescriptorPool();
+    createDrawDescriptorSets();
+    writeDrawDescriptorSets();
     createPipelineLayout();
     createPipeline();
 
+    //the thread pool's workers and the main thread each record one range of draws
+    createSecondaryCommandBuffers(static_cast<uint32_t>(engine.threadPool().threadCount()) + 1);
+
     m_uniformBufferUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::ShaderRead, vk::PipelineStageFlags::VertexShader);
     m_vertexBufferUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::VertexAttributeRead, vk::PipelineStageFlags::VertexInput);
+    m_faceBufferUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::ShaderRead, vk::PipelineStageFlags::VertexShader);
     m_indexBufferUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::IndexRead, vk::PipelineStageFlags::VertexInput);
     m_textureUsage = std::make_unique<VoxelEngine::RenderGraph::ImageUsage>(*this, vk::ImageLayout::ShaderReadOnlyOptimal, vk::AccessFlags::ShaderRead, vk::PipelineStageFlags::FragmentShader);
     m_skyboxUsage = std::make_unique<VoxelEngine::RenderGraph::ImageUsage>(*this, vk::ImageLayout::ShaderReadOnlyOptimal, vk::AccessFlags::ShaderRead, vk::PipelineStageFlags::FragmentShader);
     m_selectionTextureUsage = std::make_unique<VoxelEngine::RenderGraph::ImageUsage>(*this, vk::ImageLayout::ShaderReadOnlyOptimal, vk::AccessFlags::ShaderRead, vk::PipelineStageFlags::FragmentShader);
     m_imageUsage = std::make_unique<VoxelEngine::RenderGraph::ImageUsage>(*this, vk::ImageLayout::ColorAttachmentOptimal, vk::AccessFlags::ColorAttachmentWrite, vk::PipelineStageFlags::ColorAttachmentOutput);
+    m_indirectUsage = std::make_unique<VoxelEngine::RenderGraph::BufferUsage>(*this, vk::AccessFlags::IndirectCommandRead, vk::PipelineStageFlags::DrawIndirect);
 
     m_graphics->onSwapchainChanged().connect<&ChunkRenderer::onSwapchainChanged>(this);
 }
@@ -45,12 +66,13 @@ void ChunkRenderer::preRender(uint32_t currentFrame) {
         if (mesh.dirty()) {
             mesh.clearDirty();
 
-            m_vertexBufferUsage->sync(*mesh.mesh().getBinding(0), VK_WHOLE_SIZE, 0);
+            m_faceBufferUsage->sync(*mesh.mesh().getBinding(0), VK_WHOLE_SIZE, 0);
         }
     }
 
     m_vertexBufferUsage->sync(*m_selectionBox->mesh().getBinding(0), VK_WHOLE_SIZE, 0);
     m_vertexBufferUsage->sync(*m_selectionBox->mesh().getBinding(1), VK_WHOLE_SIZE, 0);
+    m_vertexBufferUsage->sync(m_farTerrain->vertexBuffer(), VK_WHOLE_SIZE, 0);
 
     vk::ImageSubresourceRange subresource = {};
     subresource.aspectMask = vk::ImageAspectFlags::Color;
@@ -73,6 +95,13 @@ void ChunkRenderer::preRender(uint32_t currentFrame) {
         subresource.baseArrayLayer = i;
         m_skyboxUsage->sync(m_skyboxManager->image(), subresource);
     }
+
+    if (m_indirectSupported) {
+        m_indirectUsage->sync(*m_culledBuffers[currentFrame], VK_WHOLE_SIZE, 0);
+        m_indirectUsage->sync(*m_countBuffers[currentFrame], VK_WHOLE_SIZE, 0);
+    }
+
+    buildDraws();
 }
 
 void ChunkRenderer::render(uint32_t currentFrame, vk::CommandBuffer& commandBuffer) {
@@ -83,13 +112,9 @@ void ChunkRenderer::render(uint32_t currentFrame, vk::CommandBuffer& commandBuff
     renderPassInfo.clearValues.push_back({ 0.0f, 0.0f, 0.0f, 1.0f });
 
     vk::ClearValue depthClear = {};
-    depthClear.depthStencil.depth = 1;
+    depthClear.depthStencil.depth = 0;    //depth is reversed, 0 is the far plane
     renderPassInfo.clearValues.push_back(depthClear);
 
-    commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::Inline);
-
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::Graphics, *m_pipeline);
-
     vk::Viewport viewport = {};
     viewport.width = static_cast<float>(m_graphics->swapchain().extent().width);
     viewport.height = static_cast<float>(m_graphics->swapchain().extent().height);
@@ -99,41 +124,351 @@ void ChunkRenderer::render(uint32_t currentFrame, vk::CommandBuffer& commandBuff
     vk::Rect2D scissor = {};
     scissor.extent = m_graphics->swapchain().extent();
 
+    //when culling on the GPU, ChunkCuller has already written the draws for this frame
+    if (!m_indirectSupported) {
+        writeDraws(currentFrame);
+    }
+
+    uint32_t drawCount = static_cast<uint32_t>(m_draws.size());
+    uint32_t taskCount = getRecordTaskCount();
+
+    if (taskCount <= 1) {
+        commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::Inline);
+
+        recordState(currentFrame, commandBuffer, viewport, scissor);
+        recordChunks(currentFrame, commandBuffer, 0, drawCount);
+        recordOverlays(commandBuffer, viewport, scissor);
+
+        commandBuffer.endRenderPass();
+        return;
+    }
+
+    //split the draws into contiguous ranges that are recorded into secondary command buffers in parallel
+    commandBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::SecondaryCommandBuffers);
+
+    vk::Framebuffer& framebuffer = m_framebuffers[m_acquireNode->swapchainIndex()];
+
+    m_engine->threadPool().run(taskCount, [&](size_t task) {
+        uint32_t index = static_cast<uint32_t>(task);
+        uint32_t first = static_cast<uint32_t>(uint64_t(drawCount) * index / taskCount);
+        uint32_t last = static_cast<uint32_t>(uint64_t(drawCount) * (index + 1) / taskCount);
+
+        vk::CommandBuffer& secondary = beginSecondaryCommandBuffer(currentFrame, index, *m_renderPass, 0, framebuffer);
+
+        recordState(currentFrame, secondary, viewport, scissor);
+        recordChunks(currentFrame, secondary, first, last);
+
+        //secondary command buffers are executed in order, so the last one draws everything after the chunks
+        if (index == taskCount - 1) {
+            recordOverlays(secondary, viewport, scissor);
+        }
+
+        secondary.end();
+    });
+
+    executeSecondaryCommandBuffers(currentFrame, commandBuffer, taskCount);
+
+    commandBuffer.endRenderPass();
+}
+
+uint32_t ChunkRenderer::getRecordTaskCount() const {
+    //indirect draws only need one command per batch, so recording them is never worth splitting
+    if (m_indirectSupported) return 1;
+
+    uint32_t taskCount = static_cast<uint32_t>(m_draws.size()) / minDrawsPerTask;
+    return std::clamp<uint32_t>(taskCount, 1, secondaryCommandBufferCount());
+}
+
+void ChunkRenderer::recordState(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor) {
     commandBuffer.setViewport(0, { viewport });
     commandBuffer.setScissor(0, { scissor });
 
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Graphics, *m_pipelineLayout, 0, { m_cameraSystem->descriptorSet(), m_textureManager->descriptorSet() }, nullptr);
-    commandBuffer.bindIndexBuffer(m_meshManager->indexBuffer()->buffer(), 0, vk::IndexType::Uint32);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Graphics, *m_pipelineLayout, 0, { m_cameraSystem->descriptorSet(), m_textureManager->descriptorSet(), m_drawDescriptorSets[currentFrame] }, nullptr);
+}
+
+void ChunkRenderer::recordOverlays(vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor) {
+    //drawn after the chunks so that most of it is rejected by the depth test
+    m_farTerrain->draw(commandBuffer, viewport, scissor);
+
+    m_selectionBox->draw(commandBuffer, viewport, scissor);
+    m_skyboxManager->draw(commandBuffer, viewport, scissor);
+}
+
+void ChunkRenderer::buildDraws() {
+    m_draws.clear();
+    m_batches.clear();
+    m_droppedDraws = 0;
 
     VoxelEngine::Frustum frustum = m_cameraSystem->camera().frustum();
+    m_world->cullColumns(frustum);
 
-    VkBuffer boundBuffer = VK_NULL_HANDLE;
+    //draw everything in the frustum when the camera is outside of the loaded chunks
+    if (!traverseChunks(frustum)) {
+        m_visibleChunks.clear();
+        m_world->cullChunks(frustum, m_visibleChunks);
 
-    auto view = m_world->registry().view<Chunk, ChunkMesh>();
-    for (auto entity : view) {
-        auto& chunk = view.get<Chunk>(entity);
-        auto& chunkMesh = view.get<ChunkMesh>(entity);
+        auto view = m_world->registry().view<Chunk, ChunkMesh>();
+        for (auto entity : m_visibleChunks) {
+            addDraw(view.get<Chunk>(entity), view.get<ChunkMesh>(entity));
+        }
+    }
 
-        if (chunk.loadState() != ChunkLoadState::Loaded) continue;
-        if (!frustum.testAABB(chunk.worldChunkPosition() * 16, glm::vec3(16, 16, 16))) continue;
+    if (m_droppedDraws > 0) {
+        m_droppedDrawsCounter->add(m_droppedDraws);
+    }
 
-        auto& mesh = chunkMesh.mesh();
-        auto& buffer = mesh.getBinding(0)->buffer();
+    sortDraws();
 
-        if (buffer.handle() != boundBuffer) {
-            mesh.bindVertexBuffers(commandBuffer);
-            boundBuffer = buffer.handle();
+    for (uint32_t i = 0; i < m_draws.size(); i++) {
+        if (m_batches.size() == 0 || m_batches.back().buffer != m_draws[i].buffer) {
+            m_batches.push_back({ m_draws[i].buffer, m_draws[i].descriptorSet, i, 0 });
         }
 
-        glm::ivec4 transform = glm::ivec4(chunk.worldChunkPosition(), 0) * Chunk::chunkSize;
-        commandBuffer.pushConstants(*m_pipelineLayout, vk::ShaderStageFlags::Vertex, 0, sizeof(glm::ivec4), &transform);
-        mesh.drawIndexed(commandBuffer);
+        m_batches.back().count++;
     }
+}
 
-    m_selectionBox->draw(commandBuffer, viewport, scissor);
-    m_skyboxManager->draw(commandBuffer, viewport, scissor);
+void ChunkRenderer::sortDraws() {
+    //group draws by MeshManager page so that each page needs one descriptor set bind and one indirect draw,
+    //then order each page's draws front to back so that near chunks fill the depth buffer first
+    glm::vec3 cameraPos = m_cameraSystem->camera().position();
+    const float distanceScale = 4.0f;
+    const uint32_t distanceBits = 20;
+    const uint32_t maxDistance = (1 << distanceBits) - 1;
 
-    commandBuffer.endRenderPass();
+    m_drawPages.clear();
+    m_drawKeys.clear();
+
+    for (uint32_t i = 0; i < m_draws.size(); i++) {
+        auto& draw = m_draws[i];
+
+        //pages are ranked in the order they are first seen, which is roughly near to far
+        uint32_t page = 0;
+        while (page < m_drawPages.size() && m_drawPages[page] != draw.buffer) {
+            page++;
+        }
+
+        if (page == m_drawPages.size()) {
+            m_drawPages.push_back(draw.buffer);
+        }
+
+        glm::vec3 center = glm::vec3(draw.transform) + glm::vec3(Chunk::chunkSize / 2);
+        float distance = glm::length(center - cameraPos) * distanceScale;
+        uint32_t quantized = std::min(static_cast<uint32_t>(distance), maxDistance);
+
+        uint64_t key = (static_cast<uint64_t>(page) << distanceBits) | quantized;
+        m_drawKeys.push_back((key << 32) | i);
+    }
+
+    VoxelEngine::radixSort(m_drawKeys, m_drawKeysScratch);
+
+    m_sortedDraws.clear();
+
+    for (auto key : m_drawKeys) {
+        m_sortedDraws.push_back(m_draws[key & 0xFFFFFFFF]);
+    }
+
+    m_draws.swap(m_sortedDraws);
+}
+
+bool ChunkRenderer::traverseChunks(VoxelEngine::Frustum& frustum) {
+    glm::ivec3 cameraPos = glm::ivec3(glm::floor(m_cameraSystem->camera().position()));
+    entt::entity start = m_world->getEntity(Chunk::worldToWorldChunk(cameraPos));
+    if (start == entt::null) return false;
+
+    auto view = m_world->registry().view<Chunk>();
+    if (view.get(start).loadState() != ChunkLoadState::Loaded) return false;
+
+    m_visibilitySteps.clear();
+    m_visited.clear();
+
+    m_visibilitySteps.push_back({ start, -1, 0 });
+    m_visited.insert(start);
+
+    //breadth first search from the camera's chunk, only stepping between faces that are connected inside a chunk
+    //each level's neighbors are gathered first, so their frustum tests run as one BoundsList batch
+    //the frustum test doesn't depend on the path, so a chunk that fails it can be marked visited right away
+    //chunks in columns that are entirely outside or inside the frustum skip their own test
+    size_t levelStart = 0;
+
+    while (levelStart < m_visibilitySteps.size()) {
+        size_t levelEnd = m_visibilitySteps.size();
+        m_candidateSteps.clear();
+        m_candidateBounds.clear();
+
+        for (size_t i = levelStart; i < levelEnd; i++) {
+            VisibilityStep step = m_visibilitySteps[i];
+            Chunk& chunk = view.get(step.entity);
+
+            if (m_world->registry().has<ChunkMesh>(step.entity)) {
+                addDraw(chunk, m_world->registry().get<ChunkMesh>(step.entity));
+            }
+
+            for (int32_t face = 0; face < 6; face++) {
+                //Neighbors6 is ordered in opposite pairs
+                int32_t opposite = face ^ 1;
+
+                //never step back towards the camera
+                if ((step.directions & (1 << opposite)) != 0) continue;
+                if (step.entryFace >= 0 && !chunk.connected(step.entryFace, face)) continue;
+
+                glm::ivec3 neighborPos = chunk.worldChunkPosition() + Chunk::Neighbors6[face];
+                entt::entity neighborEntity = m_world->getEntity(neighborPos);
+                if (neighborEntity == entt::null) continue;
+                if (m_visited.count(neighborEntity) > 0) continue;
+
+                Chunk& neighbor = view.get(neighborEntity);
+                if (neighbor.loadState() != ChunkLoadState::Loaded) continue;
+
+                m_visited.insert(neighborEntity);
+                VisibilityStep neighborStep = { neighborEntity, opposite, step.directions | (1 << face) };
+                ColumnVisibility column = m_world->columnVisibility({ neighborPos.x, neighborPos.z });
+
+                if (column == ColumnVisibility::Outside) continue;
+
+                //steps added past levelEnd belong to the next level
+                if (column == ColumnVisibility::Inside) {
+                    m_visibilitySteps.push_back(neighborStep);
+                    continue;
+                }
+
+                m_candidateSteps.push_back(neighborStep);
+                m_candidateBounds.append(neighborPos * Chunk::chunkSize, glm::vec3(Chunk::chunkSize));
+            }
+        }
+
+        //ids come back in the order they were added, which keeps the search breadth first
+        m_candidateVisible.clear();
+        m_candidateBounds.cull(frustum, m_candidateVisible);
+
+        for (auto index : m_candidateVisible) {
+            m_visibilitySteps.push_back(m_candidateSteps[index]);
+        }
+
+        levelStart = levelEnd;
+    }
+
+    return true;
+}
+
+void ChunkRenderer::addDraw(Chunk& chunk, ChunkMesh& chunkMesh) {
+    auto& mesh = chunkMesh.mesh();
+    auto& faceCounts = chunkMesh.faceCounts();
+
+    glm::vec3 cameraPos = m_cameraSystem->camera().position();
+    glm::vec3 min = chunk.worldChunkPosition() * Chunk::chunkSize;
+    glm::vec3 max = min + glm::vec3(Chunk::chunkSize);
+
+    //a direction group can only be seen if the camera is in front of at least one of its faces
+    std::array<bool, 6> visible = {
+        cameraPos.x > min.x,
+        cameraPos.x < max.x,
+        cameraPos.y > min.y,
+        cameraPos.y < max.y,
+        cameraPos.z > min.z,
+        cameraPos.z < max.z
+    };
+
+    auto& faceBuffer = *mesh.getBinding(0);
+    const vk::DescriptorSet* descriptorSet = &m_meshManager->descriptorSet(faceBuffer);
+
+    uint32_t face = 0;
+    DrawInfo* previous = nullptr;
+
+    for (size_t i = 0; i < 6; i++) {
+        uint32_t first = face;
+        face += faceCounts[i];
+
+        if (!visible[i] || faceCounts[i] == 0) continue;
+
+        //each face is expanded into 6 vertices by the vertex shader
+        uint32_t firstVertex = (mesh.vertexOffset() + first) * 6;
+
+        //extend the previous draw when the groups are adjacent in the face buffer
+        if (previous != nullptr && previous->firstVertex + previous->vertexCount == firstVertex) {
+            previous->vertexCount += faceCounts[i] * 6;
+            continue;
+        }
+
+        if (m_draws.size() == maxDraws) {
+            m_droppedDraws++;
+            continue;
+        }
+
+        DrawInfo draw = {};
+        draw.buffer = faceBuffer.buffer().handle();
+        draw.descriptorSet = descriptorSet;
+        draw.vertexCount = faceCounts[i] * 6;
+        draw.firstVertex = firstVertex;
+        draw.transform = glm::ivec4(chunk.worldChunkPosition(), 0) * Chunk::chunkSize;
+
+        m_draws.push_back(draw);
+        previous = &m_draws.back();
+    }
+}
+
+void ChunkRenderer::writeDraws(uint32_t currentFrame) {
+    auto commands = static_cast<VkDrawIndirectCommand*>(m_indirectBuffers[currentFrame]->getMapping());
+    auto transforms = static_cast<glm::ivec4*>(m_transformBuffers[currentFrame]->getMapping());
+
+    for (auto& batch : m_batches) {
+        for (uint32_t i = batch.offset; i < batch.offset + batch.count; i++) {
+            auto& draw = m_draws[i];
+
+            //firstInstance is used by the vertex shader to look up the chunk transform
+            VkDrawIndirectCommand& command = commands[i];
+            command.vertexCount = draw.vertexCount;
+            command.instanceCount = 1;
+            command.firstVertex = draw.firstVertex;
+            command.firstInstance = i;
+
+            //w holds the start of the batch, ChunkCuller compacts visible draws to that slot
+            transforms[i] = glm::ivec4(glm::ivec3(draw.transform), batch.offset);
+        }
+    }
+}
+
+void ChunkRenderer::recordChunks(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t lastDraw) {
+    if (m_depthPrepass) {
+        //the prepass uses the same vertex shader, so the shading pass only passes depth tests where the prepass wrote
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::Graphics, *m_depthPrepassPipeline);
+        recordDraws(currentFrame, commandBuffer, firstDraw, lastDraw);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::Graphics, *m_prepassShadePipeline);
+        recordDraws(currentFrame, commandBuffer, firstDraw, lastDraw);
+    } else {
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::Graphics, *m_pipeline);
+        recordDraws(currentFrame, commandBuffer, firstDraw, lastDraw);
+    }
+}
+
+void ChunkRenderer::recordDraws(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t lastDraw) {
+    auto commands = static_cast<VkDrawIndirectCommand*>(m_indirectBuffers[currentFrame]->getMapping());
+
+    for (auto& batch : m_batches) {
+        //indirect batches are recorded whole by the range that contains their first draw
+        if (m_indirectSupported && (batch.offset < firstDraw || batch.offset >= lastDraw)) continue;
+        if (batch.offset + batch.count <= firstDraw || batch.offset >= lastDraw) continue;
+
+        //the vertex shader reads faces from the page's storage buffer
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Graphics, *m_pipelineLayout, 3, { *batch.descriptorSet }, nullptr);
+
+        if (m_compactDraws) {
+            commandBuffer.drawIndirectCount(m_culledBuffers[currentFrame]->buffer(), batch.offset * sizeof(VkDrawIndirectCommand), m_countBuffers[currentFrame]->buffer(), batch.offset * sizeof(uint32_t), batch.count, sizeof(VkDrawIndirectCommand));
+        } else if (m_indirectSupported) {
+            //culled draws are left in place with an instance count of 0
+            commandBuffer.drawIndirect(m_culledBuffers[currentFrame]->buffer(), batch.offset * sizeof(VkDrawIndirectCommand), batch.count, sizeof(VkDrawIndirectCommand));
+        } else {
+            //fall back to direct draws when the device can't use firstInstance in indirect commands
+            uint32_t first = std::max(batch.offset, firstDraw);
+            uint32_t last = std::min(batch.offset + batch.count, lastDraw);
+
+            for (uint32_t i = first; i < last; i++) {
+                auto& command = commands[i];
+                commandBuffer.draw(command.vertexCount, command.instanceCount, command.firstVertex, command.firstInstance);
+            }
+        }
+    }
 }
 
 void ChunkRenderer::createDepthBuffer() {
@@ -141,7 +476,7 @@ void ChunkRenderer::createDepthBuffer() {
     vk::ImageCreateInfo info = {};
     info.extent = { extent.width, extent.height, 1 };
     info.format = vk::Format::D32_Sfloat;
-    info.usage = vk::ImageUsageFlags::DepthStencilAttachment;
+    info.usage = vk::ImageUsageFlags::DepthStencilAttachment | vk::ImageUsageFlags::Sampled;
     info.mipLevels = 1;
     info.arrayLayers = 1;
     info.samples = vk::SampleCountFlags::_1;
@@ -181,7 +516,7 @@ void ChunkRenderer::createRenderPass() {
     depthAttachment.format = m_depthBuffer->image().format();
     depthAttachment.samples = vk::SampleCountFlags::_1;
     depthAttachment.loadOp = vk::AttachmentLoadOp::Clear;
-    depthAttachment.storeOp = vk::AttachmentStoreOp::DontCare;
+    depthAttachment.storeOp = vk::AttachmentStoreOp::Store;    //read by ChunkCuller in the next frame
     depthAttachment.stencilLoadOp = vk::AttachmentLoadOp::DontCare;
     depthAttachment.stencilStoreOp = vk::AttachmentStoreOp::DontCare;
     depthAttachment.initialLayout = vk::ImageLayout::Undefined;
@@ -222,18 +557,108 @@ void ChunkRenderer::createFramebuffers() {
     }
 }
 
+void ChunkRenderer::createDrawBuffers() {
+    vk::BufferCreateInfo indirectInfo = {};
+    indirectInfo.size = maxDraws * sizeof(VkDrawIndirectCommand);
+    indirectInfo.usage = vk::BufferUsageFlags::IndirectBuffer | vk::BufferUsageFlags::StorageBuffer;
+    indirectInfo.sharingMode = vk::SharingMode::Exclusive;
+
+    vk::BufferCreateInfo transformInfo = {};
+    transformInfo.size = maxDraws * sizeof(glm::ivec4);
+    transformInfo.usage = vk::BufferUsageFlags::StorageBuffer;
+    transformInfo.sharingMode = vk::SharingMode::Exclusive;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    allocInfo.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    allocInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        m_indirectBuffers.emplace_back(std::make_unique<VoxelEngine::Buffer>(*m_engine, indirectInfo, allocInfo));
+        m_transformBuffers.emplace_back(std::make_unique<VoxelEngine::Buffer>(*m_engine, transformInfo, allocInfo));
+    }
+
+    if (!m_indirectSupported) return;
+
+    //written by ChunkCuller
+    vk::BufferCreateInfo culledInfo = {};
+    culledInfo.size = maxDraws * sizeof(VkDrawIndirectCommand);
+    culledInfo.usage = vk::BufferUsageFlags::IndirectBuffer | vk::BufferUsageFlags::StorageBuffer;
+    culledInfo.sharingMode = vk::SharingMode::Exclusive;
+
+    vk::BufferCreateInfo countInfo = {};
+    countInfo.size = maxDraws * sizeof(uint32_t);
+    countInfo.usage = vk::BufferUsageFlags::IndirectBuffer | vk::BufferUsageFlags::StorageBuffer | vk::BufferUsageFlags::TransferDst;
+    countInfo.sharingMode = vk::SharingMode::Exclusive;
+
+    VmaAllocationCreateInfo gpuAllocInfo = {};
+    gpuAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    gpuAllocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        m_culledBuffers.emplace_back(std::make_unique<VoxelEngine::Buffer>(*m_engine, culledInfo, gpuAllocInfo));
+        m_countBuffers.emplace_back(std::make_unique<VoxelEngine::Buffer>(*m_engine, countInfo, gpuAllocInfo));
+    }
+}
+
+void ChunkRenderer::createDrawDescriptorSetLayout() {
+    vk::DescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = vk::DescriptorType::StorageBuffer;
+    binding.descriptorCount = 1;
+    binding.stageFlags = vk::ShaderStageFlags::Vertex;
+
+    vk::DescriptorSetLayoutCreateInfo info = {};
+    info.bindings = { binding };
+
+    m_drawDescriptorSetLayout = std::make_unique<vk::DescriptorSetLayout>(m_graphics->device(), info);
+}
+
+void ChunkRenderer::createDrawDescriptorPool() {
+    vk::DescriptorPoolCreateInfo info = {};
+    info.maxSets = graph().framesInFlight();
+    info.poolSizes = { { vk::DescriptorType::StorageBuffer, graph().framesInFlight() } };
+
+    m_drawDescriptorPool = std::make_unique<vk::DescriptorPool>(m_graphics->device(), info);
+}
+
+void ChunkRenderer::createDrawDescriptorSets() {
+    vk::DescriptorSetAllocateInfo info = {};
+    info.descriptorPool = m_drawDescriptorPool.get();
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        info.setLayouts.push_back(*m_drawDescriptorSetLayout);
+    }
+
+    m_drawDescriptorSets = m_drawDescriptorPool->allocate(info);
+}
+
+void ChunkRenderer::writeDrawDescriptorSets() {
+    std::vector<vk::WriteDescriptorSet> writes;
+
+    for (uint32_t i = 0; i < graph().framesInFlight(); i++) {
+        vk::DescriptorBufferInfo info = {};
+        info.buffer = &m_transformBuffers[i]->buffer();
+        info.range = maxDraws * sizeof(glm::ivec4);
+
+        vk::WriteDescriptorSet write = {};
+        write.dstSet = &m_drawDescriptorSets[i];
+        write.bufferInfo = { info };
+        write.descriptorType = vk::DescriptorType::StorageBuffer;
+
+        writes.push_back(write);
+    }
+
+    vk::DescriptorSet::update(m_graphics->device(), writes, nullptr);
+}
+
 void ChunkRenderer::createPipelineLayout() {
     vk::PipelineLayoutCreateInfo info = {};
     info.setLayouts = {
         m_cameraSystem->descriptorLayout(),
-        m_textureManager->descriptorSetLayout()
-    };
-    info.pushConstantRanges = {
-        {
-            vk::ShaderStageFlags::Vertex,
-            0,
-            sizeof(glm::ivec4)
-        }
+        m_textureManager->descriptorSetLayout(),
+        *m_drawDescriptorSetLayout,
+        m_meshManager->descriptorSetLayout()
     };
 
     m_pipelineLayout = std::make_unique<vk::PipelineLayout>(m_graphics->device(), info);
@@ -258,23 +683,8 @@ void ChunkRenderer::createPipeline() {
 
     std::vector<vk::PipelineShaderStageCreateInfo> stages = { std::move(vertInfo), std::move(fragInfo) };
 
+    //faces are read from a storage buffer in the vertex shader, so there are no vertex attributes
     vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {};
-    vertexInputInfo.vertexBindingDescriptions = {
-        {
-            0, sizeof(ChunkVertex)
-        }
-    };
-    vertexInputInfo.vertexAttributeDescriptions = {
-        {
-            0, 0, vk::Format::R8G8B8A8_Sint, 0
-        },
-        {
-            1, 0, vk::Format::R8G8B8A8_Unorm, sizeof(glm::i8vec4)
-        },
-        {
-            2, 0, vk::Format::R8G8B8A8_Sint, sizeof(glm::i8vec4) * 2
-        },
-    };
 
     vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
     inputAssemblyInfo.topology = vk::PrimitiveTopology::TriangleList;
@@ -306,7 +716,7 @@ void ChunkRenderer::createPipeline() {
     vk::PipelineDepthStencilStateCreateInfo depthInfo = {};
     depthInfo.depthTestEnable = true;
     depthInfo.depthWriteEnable = true;
-    depthInfo.depthCompareOp = vk::CompareOp::Less;
+    depthInfo.depthCompareOp = vk::CompareOp::Greater;
 
     vk::PipelineDynamicStateCreateInfo dynamicInfo = {};
     dynamicInfo.dynamicStates = { vk::DynamicState::Viewport, vk::DynamicState::Scissor };
@@ -325,7 +735,29 @@ void ChunkRenderer::createPipeline() {
     info.renderPass = m_renderPass.get();
     info.subpass = 0;
 
-    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_graphics->device(), info);
+    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_graphics->device(), info, &m_graphics->pipelineCache());
+
+    //the shading pass after a depth prepass only needs to match the depth that is already written
+    depthInfo.depthWriteEnable = false;
+    depthInfo.depthCompareOp = vk::CompareOp::GreaterOrEqual;
+
+    m_prepassShadePipeline = std::make_unique<vk::GraphicsPipeline>(m_graphics->device(), info, &m_graphics->pipelineCache());
+
+    //the fragment shader never discards, so the prepass doesn't need one
+    depthInfo.depthWriteEnable = true;
+    depthInfo.depthCompareOp = vk::CompareOp::Greater;
+    colorBlendState.colorWriteMask = {};
+    colorBlendInfo.attachments = { colorBlendState };
+
+    vk::PipelineShaderStageCreateInfo prepassVertInfo = {};
+    prepassVertInfo.module = &vertShader;
+    prepassVertInfo.name = "main";
+    prepassVertInfo.stage = vk::ShaderStageFlags::Vertex;
+
+    std::vector<vk::PipelineShaderStageCreateInfo> prepassStages = { std::move(prepassVertInfo) };
+    info.stages = prepassStages;
+
+    m_depthPrepassPipeline = std::make_unique<vk::GraphicsPipeline>(m_graphics->device(), info, &m_graphics->pipelineCache());
 }
 
 void ChunkRenderer::onSwapchainChanged(vk::Swapchain& swapchain) {
@@ -6,26 +6,74 @@
 #include <Engine/RenderGraph/TransferNode.h>
 #include <Engine/CameraSystem.h>
 #include <entt/entt.hpp>
+#include <unordered_set>
 
 #include "TextureManager.h"
 #include "SkyboxManager.h"
 #include "SelectionBox.h"
+#include "FarTerrain.h"
 #include "World.h"
 
 class MeshManager;
+class ChunkMesh;
 
 class ChunkRenderer :public VoxelEngine::RenderGraph::Node {
+    struct DrawInfo {
+        VkBuffer buffer;
+        const vk::DescriptorSet* descriptorSet;
+        uint32_t vertexCount;
+        uint32_t firstVertex;
+        glm::ivec4 transform;
+    };
+
+    struct DrawBatch {
+        VkBuffer buffer;
+        const vk::DescriptorSet* descriptorSet;
+        uint32_t offset;
+        uint32_t count;
+    };
+
+    struct VisibilityStep {
+        entt::entity entity;
+        int32_t entryFace;
+        uint32_t directions;
+    };
+
 public:
-    ChunkRenderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::AcquireNode& acquireNode, VoxelEngine::TransferNode& transferNode, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, MeshManager& meshManager);
+    static const uint32_t maxDraws = 65536;
+    static const uint32_t minDrawsPerTask = 2048;
+
+    ChunkRenderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph, VoxelEngine::AcquireNode& acquireNode, VoxelEngine::TransferNode& transferNode, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, FarTerrain& farTerrain, MeshManager& meshManager);
 
     vk::RenderPass& renderPass() const { return *m_renderPass; }
+    VoxelEngine::Image& depthBuffer() const { return *m_depthBuffer; }
+    vk::ImageView& depthBufferView() const { return *m_depthBufferView; }
+    VoxelEngine::Buffer& indirectBuffer(uint32_t frame) const { return *m_indirectBuffers[frame]; }
+    VoxelEngine::Buffer& transformBuffer(uint32_t frame) const { return *m_transformBuffers[frame]; }
+    VoxelEngine::Buffer& culledBuffer(uint32_t frame) const { return *m_culledBuffers[frame]; }
+    VoxelEngine::Buffer& countBuffer(uint32_t frame) const { return *m_countBuffers[frame]; }
+    uint32_t drawCount() const { return static_cast<uint32_t>(m_draws.size()); }
+    uint32_t batchCount() const { return static_cast<uint32_t>(m_batches.size()); }
+    //first draw and draw count of the batch
+    glm::uvec2 batchRange(uint32_t index) const { return { m_batches[index].offset, m_batches[index].count }; }
+    //draws that didn't fit in maxDraws this frame, their chunks are not drawn
+    uint32_t droppedDrawCount() const { return m_droppedDraws; }
+    bool indirectSupported() const { return m_indirectSupported; }
+    bool compactDraws() const { return m_compactDraws; }
+    //draws the chunks' depth first, so that each pixel is only shaded once
+    bool depthPrepass() const { return m_depthPrepass; }
+    void setDepthPrepass(bool depthPrepass) { m_depthPrepass = depthPrepass; }
     VoxelEngine::RenderGraph::BufferUsage& uniformBufferUsage() const { return *m_uniformBufferUsage; }
     VoxelEngine::RenderGraph::BufferUsage& vertexBufferUsage() const { return *m_vertexBufferUsage; }
+    VoxelEngine::RenderGraph::BufferUsage& faceBufferUsage() const { return *m_faceBufferUsage; }
     VoxelEngine::RenderGraph::BufferUsage& indexBufferUsage() const { return *m_indexBufferUsage; }
     VoxelEngine::RenderGraph::ImageUsage& textureUsage() const { return *m_textureUsage; }
     VoxelEngine::RenderGraph::ImageUsage& skyboxUsage() const { return *m_skyboxUsage; }
     VoxelEngine::RenderGraph::ImageUsage& selectionTextureUsage() const { return *m_selectionTextureUsage; }
     VoxelEngine::RenderGraph::ImageUsage& imageUsage() const { return *m_imageUsage; }
+    VoxelEngine::RenderGraph::BufferUsage& indirectUsage() const { return *m_indirectUsage; }
+
+    void writeDraws(uint32_t currentFrame);
 
     void preRender(uint32_t currentFrame);
     void render(uint32_t currentFrame, vk::CommandBuffer& commandBuffer);
@@ -41,6 +89,7 @@ private:
     TextureManager* m_textureManager;
     SkyboxManager* m_skyboxManager;
     SelectionBox* m_selectionBox;
+    FarTerrain* m_farTerrain;
     MeshManager* m_meshManager;
 
     std::unique_ptr<VoxelEngine::Image> m_depthBuffer;
@@ -49,20 +98,64 @@ private:
     std::vector<vk::Framebuffer> m_framebuffers;
     std::unique_ptr<vk::PipelineLayout> m_pipelineLayout;
     std::unique_ptr<vk::Pipeline> m_pipeline;
+    std::unique_ptr<vk::Pipeline> m_depthPrepassPipeline;
+    std::unique_ptr<vk::Pipeline> m_prepassShadePipeline;
+
+    std::unique_ptr<vk::DescriptorSetLayout> m_drawDescriptorSetLayout;
+    std::unique_ptr<vk::DescriptorPool> m_drawDescriptorPool;
+    std::vector<vk::DescriptorSet> m_drawDescriptorSets;
+    std::vector<std::unique_ptr<VoxelEngine::Buffer>> m_indirectBuffers;
+    std::vector<std::unique_ptr<VoxelEngine::Buffer>> m_transformBuffers;
+    std::vector<std::unique_ptr<VoxelEngine::Buffer>> m_culledBuffers;
+    std::vector<std::unique_ptr<VoxelEngine::Buffer>> m_countBuffers;
+    std::vector<DrawInfo> m_draws;
+    std::vector<DrawInfo> m_sortedDraws;
+    std::vector<uint64_t> m_drawKeys;
+    std::vector<uint64_t> m_drawKeysScratch;
+    std::vector<VkBuffer> m_drawPages;
+    std::vector<DrawBatch> m_batches;
+    std::vector<VisibilityStep> m_visibilitySteps;
+    std::unordered_set<entt::entity> m_visited;
+    std::vector<VisibilityStep> m_candidateSteps;
+    VoxelEngine::BoundsList m_candidateBounds;
+    std::vector<uint32_t> m_candidateVisible;
+    std::vector<entt::entity> m_visibleChunks;
+    bool m_indirectSupported;
+    bool m_compactDraws;
+    bool m_depthPrepass;
+    uint32_t m_droppedDraws;
+    VoxelEngine::Counter* m_droppedDrawsCounter;
 
     std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_uniformBufferUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_vertexBufferUsage;
+    std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_faceBufferUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_indexBufferUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::ImageUsage> m_textureUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::ImageUsage> m_skyboxUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::ImageUsage> m_selectionTextureUsage;
     std::unique_ptr<VoxelEngine::RenderGraph::ImageUsage> m_imageUsage;
+    std::unique_ptr<VoxelEngine::RenderGraph::BufferUsage> m_indirectUsage;
 
     void createDepthBuffer();
     void createRenderPass();
     void createFramebuffers();
+    void createDrawBuffers();
+    void createDrawDescriptorSetLayout();
+    void createDrawDescriptorPool();
+    void createDrawDescriptorSets();
+    void writeDrawDescriptorSets();
     void createPipelineLayout();
     void createPipeline();
 
+    void buildDraws();
+    void sortDraws();
+    bool traverseChunks(VoxelEngine::Frustum& frustum);
+    void addDraw(Chunk& chunk, ChunkMesh& chunkMesh);
+    uint32_t getRecordTaskCount() const;
+    void recordState(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor);
+    void recordChunks(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t lastDraw);
+    void recordDraws(uint32_t currentFrame, vk::CommandBuffer& commandBuffer, uint32_t firstDraw, uint32_t lastDraw);
+    void recordOverlays(vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor);
+
     void onSwapchainChanged(vk::Swapchain& swapchain);
 };
\ No newline at end of file
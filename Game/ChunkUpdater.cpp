@@ -2,11 +2,20 @@
 #include "Chunk.h"
 #include "ChunkMesh.h"
 
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define VOXEL_SSE2
+#endif
+
 ChunkUpdater::ChunkUpdater(VoxelEngine::Engine& engine, World& world, BlockManager& blockManager, ChunkManager& chunkManager) : m_requestQueue(queueSize) {
     m_engine = &engine;
     m_world = &world;
     m_blockManager = &blockManager;
     m_chunkManager = &chunkManager;
+
+    m_updateWaitHistogram = &VoxelEngine::Metrics::histogram("update.wait");
+    m_updateServiceHistogram = &VoxelEngine::Metrics::histogram("update.service");
+    m_updateCompletedCounter = &VoxelEngine::Metrics::counter("update.completed");
 }
 
 void ChunkUpdater::run() {
@@ -21,25 +30,54 @@ void ChunkUpdater::stop() {
 }
 
 bool ChunkUpdater::queue(glm::ivec3 coord) {
-    return m_requestQueue.tryEnqueue(coord);
+    return m_requestQueue.tryEnqueue({ coord, VoxelEngine::Metrics::now() });
+}
+
+size_t ChunkUpdater::queueBulk(const std::vector<glm::ivec3>& coords) {
+    uint64_t time = VoxelEngine::Metrics::now();
+    m_bulkRequests.clear();
+
+    for (auto coord : coords) {
+        m_bulkRequests.push_back({ coord, time });
+    }
+
+    return m_requestQueue.tryEnqueueBulk(m_bulkRequests.data(), m_bulkRequests.size());
 }
 
 void ChunkUpdater::loop() {
+    VOXEL_PROFILE_THREAD("ChunkUpdater");
+
+    std::vector<Request> requests;
+
     while (m_running) {
-        glm::ivec3 coord;
-        bool valid = m_requestQueue.dequeue(coord);
-        if (!valid) return;
+        requests.clear();
+        if (!m_requestQueue.dequeueUpTo(requests, batchSize)) return;
 
-        update(coord);
+        for (auto& request : requests) {
+            uint64_t start = VoxelEngine::Metrics::now();
+            m_updateWaitHistogram->record(start - request.time);
+
+            update(request.coord);
+
+            m_updateServiceHistogram->record(VoxelEngine::Metrics::now() - start);
+            m_updateCompletedCounter->add();
+        }
     }
 }
 
 void ChunkUpdater::update(glm::ivec3 worldChunkPos) {
+    VOXEL_PROFILE_SCOPE("ChunkUpdater::update");
     ChunkBuffer blocks;
     LightBuffer light;
     ChunkData<Chunk*, 3> neighborChunks;
     const glm::ivec3 root = { 1, 1, 1 };
     std::queue<LightUpdate> queue;
+    std::queue<LightUpdate> removals;
+
+    //edited blocks that touch each other share relight positions, each position is only forced once
+    ChunkData<bool, Chunk::chunkSize + 2> relight;
+    bool edited = false;
+    uint64_t editGeneration = 0;
 
     {
         auto lock = m_world->getLock();
@@ -86,19 +124,39 @@ void ChunkUpdater::update(glm::ivec3 worldChunkPos) {
             }
         }
 
+        //region updates are queued under the same lock as the generation, so every edit up to it is taken below
+        editGeneration = chunk.editGeneration();
+
         auto& blockUpdates = chunk.getBlockUpdates();
+        edited = blockUpdates.size() > 0;
+
+        auto& regionUpdates = chunk.getRegionUpdates();
+
+        while (regionUpdates.size() > 0) {
+            auto& update = regionUpdates.front();
+            applyRegionUpdate(update, blocks);
+            edited = true;
+
+            for (int32_t x = update.min.x - 1; x <= update.max.x + 1; x++) {
+                for (int32_t y = update.min.y - 1; y <= update.max.y + 1; y++) {
+                    for (int32_t z = update.min.z - 1; z <= update.max.z + 1; z++) {
+                        relight[root + glm::ivec3(x, y, z)] = true;
+                    }
+                }
+            }
+
+            regionUpdates.pop();
+        }
 
         while (blockUpdates.size() > 0) {
             auto update = blockUpdates.front();
             blockUpdates.pop();
 
             blocks[root + update.inChunkPos] = update.block;
-
-            queue.push({ light[root + update.inChunkPos], update.inChunkPos, true });
+            relight[root + update.inChunkPos] = true;
 
             for (auto offset : Chunk::Neighbors6) {
-                auto neighborPos = update.inChunkPos + offset;
-                queue.push({ light[root + neighborPos], neighborPos, true });
+                relight[root + update.inChunkPos + offset] = true;
             }
         }
 
@@ -107,13 +165,88 @@ void ChunkUpdater::update(glm::ivec3 worldChunkPos) {
         while (lightUpdates.size() > 0) {
             auto update = lightUpdates.front();
             lightUpdates.pop();
-            queue.push(update);
+
+            if (update.removal) {
+                removals.push(update);
+            } else {
+                queue.push(update);
+            }
+        }
+    }
+
+    //block light around edited blocks is removed first, then refilled from the remaining sources by the forced updates
+    for (glm::ivec3 pos : Chunk::Positions()) {
+        if (!edited) break;
+        if (!relight[root + pos] || light[root + pos].block() == 0) continue;
+
+        clearBlockLight(pos, removals, queue, blocks, light, neighborChunks);
+    }
+
+    removeLight(removals, queue, blocks, light, neighborChunks);
+
+    for (int32_t x = -1; edited && x < Chunk::chunkSize + 1; x++) {
+        for (int32_t y = -1; y < Chunk::chunkSize + 1; y++) {
+            for (int32_t z = -1; z < Chunk::chunkSize + 1; z++) {
+                glm::ivec3 pos = { x, y, z };
+                if (!relight[root + pos]) continue;
+
+                queue.push({ light[root + pos], pos, true });
+            }
         }
     }
 
     updateLight(queue, blocks, light, neighborChunks);
 
-    m_chunkManager->updateResultQueue().enqueue({ worldChunkPos, blocks, light });
+    m_chunkManager->updateResultQueue().enqueue({ worldChunkPos, blocks, light, editGeneration });
+}
+
+void ChunkUpdater::applyRegionUpdate(const RegionUpdate& update, ChunkBuffer& chunkBuffer) {
+    static_assert(sizeof(Block) == 1, "Block must be one byte");
+    const glm::ivec3 root = { 1, 1, 1 };
+    size_t length = update.max.x - update.min.x + 1;
+
+#ifdef VOXEL_SSE2
+    //lanes of a chunk row that are inside the region
+    const __m128i lanes = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i inRange = _mm_and_si128(
+        _mm_cmpgt_epi8(lanes, _mm_set1_epi8(static_cast<char>(update.min.x - 1))),
+        _mm_cmplt_epi8(lanes, _mm_set1_epi8(static_cast<char>(update.max.x + 1)))
+    );
+    const __m128i from = _mm_set1_epi8(static_cast<char>(update.from.type));
+    const __m128i to = _mm_set1_epi8(static_cast<char>(update.block.type));
+#endif
+
+    for (int32_t z = update.min.z; z <= update.max.z; z++) {
+        for (int32_t y = update.min.y; y <= update.max.y; y++) {
+            Block* row = &chunkBuffer[root + glm::ivec3(0, y, z)];
+
+            switch (update.operation) {
+            case RegionOperation::Fill:
+                memset(row + update.min.x, update.block.type, length);
+                break;
+            case RegionOperation::Replace: {
+#ifdef VOXEL_SSE2
+                __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+                __m128i mask = _mm_and_si128(_mm_cmpeq_epi8(data, from), inRange);
+                data = _mm_or_si128(_mm_and_si128(mask, to), _mm_andnot_si128(mask, data));
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(row), data);
+#else
+                for (int32_t x = update.min.x; x <= update.max.x; x++) {
+                    if (row[x].type == update.from.type) {
+                        row[x] = update.block;
+                    }
+                }
+#endif
+                break;
+            }
+            case RegionOperation::Paste: {
+                glm::ivec3 sourcePos = update.sourcePos + glm::ivec3(0, y - update.min.y, z - update.min.z);
+                memcpy(row + update.min.x, &update.source->blocks[update.source->index(sourcePos)], length);
+                break;
+            }
+            }
+        }
+    }
 }
 
 void ChunkUpdater::updateLight(std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks) {
@@ -128,15 +261,20 @@ void ChunkUpdater::updateLight(std::queue<LightUpdate>& queue, ChunkBuffer& chun
         if (!(lightBuffer[root + pos] < light) && !force) continue;
 
         auto& block = chunkBuffer[root + pos];
-        auto& blockType = m_blockManager->getType(block);
+        int32_t emission = m_blockManager->emission(block);
 
-        if (blockType.solid()) {
-            lightBuffer[root + pos] = {};
-            continue;
+        if (m_blockManager->lightAttenuation(block) >= BlockManager::maxAttenuation) {
+            //light can't enter the block, but an emissive block still lights its neighbors
+            lightBuffer[root + pos] = Light(0, emission);
+            if (emission == 0) continue;
         } else {
+            Light emitted(0, emission);
             lightBuffer[root + pos].overwrite(light);
+            lightBuffer[root + pos].overwrite(emitted);
         }
 
+        light = lightBuffer[root + pos];
+
         for (auto offset : Chunk::Neighbors6) {
             glm::ivec3 neighborPos = pos + offset;
             auto neighborResults = Chunk::split(neighborPos);
@@ -149,12 +287,15 @@ void ChunkUpdater::updateLight(std::queue<LightUpdate>& queue, ChunkBuffer& chun
                 loss = 0;
             }
 
-            Light newLight(std::max<int8_t>(0, light.sun - loss));
+            //block light loses one level in every direction
+            Light newLight(light.sun() - loss, light.block() - 1);
 
             if (neighborChunkOffset == glm::ivec3()) {
                 Block& block = chunkBuffer[root + neighborPosMod];
+                int32_t attenuation = m_blockManager->lightAttenuation(block);
 
-                if (block.type > 1) continue;
+                if (attenuation >= BlockManager::maxAttenuation) continue;
+                newLight = Light(newLight.sun() - attenuation, newLight.block() - attenuation);
 
                 Light& currentLight = lightBuffer[root + neighborPosMod];
                 if (newLight > currentLight) {
@@ -169,4 +310,54 @@ void ChunkUpdater::updateLight(std::queue<LightUpdate>& queue, ChunkBuffer& chun
             }
         }
     }
+}
+
+void ChunkUpdater::removeLight(std::queue<LightUpdate>& removals, std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks) {
+    //each removal carries the level of the neighbor that was cleared
+    //darker blocks were lit by that neighbor and are cleared too, brighter blocks have another source and refill the area
+    const glm::ivec3 root = { 1, 1, 1 };
+
+    while (removals.size() > 0) {
+        int32_t level = removals.front().light.block();
+        auto pos = removals.front().inChunkPos;
+        removals.pop();
+
+        int32_t current = lightBuffer[root + pos].block();
+        if (current == 0) continue;
+
+        if (current < level) {
+            clearBlockLight(pos, removals, queue, chunkBuffer, lightBuffer, neighborChunks);
+        } else {
+            queue.push({ lightBuffer[root + pos], pos, true });
+        }
+    }
+}
+
+void ChunkUpdater::clearBlockLight(glm::ivec3 pos, std::queue<LightUpdate>& removals, std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks) {
+    const glm::ivec3 root = { 1, 1, 1 };
+    Light& light = lightBuffer[root + pos];
+    Light removed(0, light.block());
+    int32_t emission = m_blockManager->emission(chunkBuffer[root + pos]);
+
+    light = Light(light.sun(), 0);
+
+    if (emission > 0) {
+        queue.push({ Light(light.sun(), emission), pos, true });
+    }
+
+    for (auto offset : Chunk::Neighbors6) {
+        auto neighborResults = Chunk::split(pos + offset);
+        glm::ivec3 neighborChunkOffset = neighborResults[0];
+        glm::ivec3 neighborPosMod = neighborResults[1];
+
+        if (neighborChunkOffset == glm::ivec3()) {
+            removals.push({ removed, neighborPosMod, false, true });
+        } else {
+            Chunk* neighborChunk = neighborChunks[root + neighborChunkOffset];
+
+            if (neighborChunk != nullptr) {
+                neighborChunk->queueLightUpdate({ removed, neighborPosMod, false, true });
+            }
+        }
+    }
 }
\ No newline at end of file
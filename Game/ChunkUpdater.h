@@ -1,6 +1,7 @@
 #pragma once
 #include <Engine/Engine.h>
 #include <Engine/BlockingQueue.h>
+#include <Engine/Metrics.h>
 #include <Engine/BufferedQueue.h>
 #include <entt/entt.hpp>
 #include "Chunk.h"
@@ -12,19 +13,31 @@ struct UpdateResults {
     glm::ivec3 worldChunkPos;
     ChunkData<Block, Chunk::chunkSize + 2> blockBuffer;
     ChunkData<Light, Chunk::chunkSize + 2> lightBuffer;
+    uint64_t editGeneration;    //every edit up to this id is included
 };
 
 class ChunkUpdater {
 public:
     static const size_t queueSize = 16;
+    static const size_t batchSize = 4;
     ChunkUpdater(VoxelEngine::Engine& engine, World& world, BlockManager& blockManager, ChunkManager& chunkManager);
 
+    std::thread& thread() { return m_thread; }
+
     void run();
     void stop();
 
     bool queue(glm::ivec3 coord);
+    size_t queueBulk(const std::vector<glm::ivec3>& coords);
+    size_t pendingCount() const { return m_requestQueue.size(); }
+    size_t freeCount() const { return queueSize - m_requestQueue.size(); }
 
 private:
+    struct Request {
+        glm::ivec3 coord;
+        uint64_t time;
+    };
+
     using ChunkBuffer = ChunkData<Block, Chunk::chunkSize + 2>;
     using LightBuffer = ChunkData<Light, Chunk::chunkSize + 2>;
 
@@ -33,13 +46,21 @@ private:
     BlockManager* m_blockManager;
     ChunkManager* m_chunkManager;
 
-    bool m_running = false;
+    std::atomic<bool> m_running = false;
     std::thread m_thread;
 
-    VoxelEngine::BlockingQueue<glm::ivec3> m_requestQueue;
+    VoxelEngine::Histogram* m_updateWaitHistogram;
+    VoxelEngine::Histogram* m_updateServiceHistogram;
+    VoxelEngine::Counter* m_updateCompletedCounter;
+
+    VoxelEngine::BlockingQueue<Request> m_requestQueue;
+    std::vector<Request> m_bulkRequests;
 
     void update(glm::ivec3 worldChunkPos);
+    static void applyRegionUpdate(const RegionUpdate& update, ChunkBuffer& chunkBuffer);
     void updateLight(std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks);
+    void removeLight(std::queue<LightUpdate>& removals, std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks);
+    void clearBlockLight(glm::ivec3 pos, std::queue<LightUpdate>& removals, std::queue<LightUpdate>& queue, ChunkBuffer& chunkBuffer, LightBuffer& lightBuffer, ChunkData<Chunk*, 3>& neighborChunks);
 
     void loop();
 };
\ No newline at end of file
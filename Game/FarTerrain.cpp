@@ -0,0 +1,316 @@
+#include "FarTerrain.h"
+#include <Engine/Utilities.h>
+#include "Chunk.h"
+#include "TerrainGenerator.h"
+#include "TextureManager.h"
+#include "ChunkManager.h"
+
+FarTerrain::FarTerrain(VoxelEngine::Engine& engine, VoxelEngine::CameraSystem& cameraSystem, TerrainGenerator& terrainGenerator, TextureManager& textureManager, ChunkManager& chunkManager) : m_requestQueue(1) {
+    m_engine = &engine;
+    m_cameraSystem = &cameraSystem;
+    m_terrainGenerator = &terrainGenerator;
+    m_textureManager = &textureManager;
+    m_chunkManager = &chunkManager;
+    m_transferNode = nullptr;
+
+    m_grassLayer = static_cast<float>(textureManager.findTexture("grass_top.png"));
+    m_stoneLayer = static_cast<float>(textureManager.findTexture("stone.png"));
+
+    //level 0 is a full grid, every other level leaves a hole for the level inside of it
+    size_t cellCount = (gridSize * gridSize) + ((levelCount - 1) * (gridSize * gridSize * 3 / 4));
+    m_maxVertexCount = cellCount * 6;
+
+    createVertexBuffers();
+    createPipelineLayout();
+}
+
+void FarTerrain::setTransferNode(VoxelEngine::TransferNode& transferNode) {
+    m_transferNode = &transferNode;
+}
+
+void FarTerrain::run() {
+    m_running = true;
+    m_thread = std::thread([this] { loop(); });
+}
+
+void FarTerrain::stop() {
+    m_running = false;
+    m_requestQueue.cancel();
+    m_thread.join();
+}
+
+void FarTerrain::loop() {
+    VOXEL_PROFILE_THREAD("FarTerrain");
+
+    while (m_running) {
+        glm::ivec2 center;
+        bool valid = m_requestQueue.dequeue(center);
+        if (!valid) return;
+
+        FarTerrainResults results = {};
+        results.center = center;
+        generate(center, results.vertices);
+
+        m_resultQueue.enqueue(std::move(results));
+    }
+}
+
+void FarTerrain::update(VoxelEngine::Clock& clock) {
+    if (m_transferNode == nullptr) return;
+
+    m_framesSinceSwap++;
+
+    glm::ivec2 center = getCenter();
+
+    if (!m_centerValid || center != m_center) {
+        if (m_requestQueue.tryEnqueue(center)) {
+            m_center = center;
+            m_centerValid = true;
+        }
+    }
+
+    auto& results = m_resultQueue.swapDequeue();
+
+    while (results.size() > 0) {
+        m_pending = std::move(results.front());
+        m_hasPending = true;
+        results.pop();
+    }
+
+    //the back buffer can only be overwritten once every frame that drew from it has finished
+    if (m_hasPending && m_framesSinceSwap >= m_engine->renderGraph().framesInFlight()) {
+        size_t next = (m_bufferIndex + 1) % m_vertexBuffers.size();
+
+        m_transferNode->transfer(*m_vertexBuffers[next], m_pending.vertices.size() * sizeof(FarVertex), 0, m_pending.vertices.data());
+
+        m_bufferIndex = next;
+        m_vertexCount = m_pending.vertices.size();
+        m_framesSinceSwap = 0;
+        m_hasPending = false;
+    }
+}
+
+void FarTerrain::draw(vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor) {
+    if (m_vertexCount == 0) return;
+
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::Graphics, *m_pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::Graphics, *m_pipelineLayout, 0, { m_cameraSystem->descriptorSet(), m_textureManager->descriptorSet() }, nullptr);
+    commandBuffer.setViewport(0, { viewport });
+    commandBuffer.setScissor(0, { scissor });
+
+    //fragments inside of the loaded chunks are discarded
+    glm::vec4 data = glm::vec4(getChunkCenter(), innerRadius(), 0);
+    commandBuffer.pushConstants(*m_pipelineLayout, vk::ShaderStageFlags::Fragment, 0, sizeof(glm::vec4), &data);
+
+    commandBuffer.bindVertexBuffers(0, { m_vertexBuffers[m_bufferIndex]->buffer() }, { 0 });
+    commandBuffer.draw(static_cast<uint32_t>(m_vertexCount), 1, 0, 0);
+}
+
+void FarTerrain::generate(glm::ivec2 center, std::vector<FarVertex>& vertices) {
+    VOXEL_PROFILE_SCOPE("FarTerrain::generate");
+    //cells that are entirely inside of the loaded chunks are skipped, with a margin for the camera moving before the next rebuild
+    float skipRadius = innerRadius() - (3 * cellSize);
+    const int32_t samples = gridSize + 1;
+
+    m_heights.resize(samples * samples);
+    vertices.reserve(m_maxVertexCount);
+
+    for (int32_t level = 0; level < levelCount; level++) {
+        int32_t size = cellSize << level;
+        glm::ivec2 snapped = {
+            Chunk::divide(center.x, size * 2)[0] * size * 2,
+            Chunk::divide(center.y, size * 2)[0] * size * 2
+        };
+        glm::ivec2 origin = snapped - glm::ivec2(gridSize / 2 * size);
+
+        //the previous level is snapped to this level's cell size, so its hole starts one cell later when the snapping differs
+        glm::ivec2 holeStart = glm::ivec2(gridSize / 4);
+        holeStart.x += Chunk::divide(center.x, size)[0] - (snapped.x / size);
+        holeStart.y += Chunk::divide(center.y, size)[0] - (snapped.y / size);
+        glm::ivec2 holeEnd = holeStart + glm::ivec2(gridSize / 2);
+
+        for (int32_t x = 0; x < samples; x++) {
+            for (int32_t z = 0; z < samples; z++) {
+                glm::ivec2 pos = origin + glm::ivec2(x, z) * size;
+                m_heights[x + (z * samples)] = m_terrainGenerator->getHeight(pos.x, pos.y) + 1;
+            }
+        }
+
+        for (int32_t x = 0; x < gridSize; x++) {
+            for (int32_t z = 0; z < gridSize; z++) {
+                if (level > 0 && x >= holeStart.x && x < holeEnd.x && z >= holeStart.y && z < holeEnd.y) continue;
+
+                glm::vec2 pos = glm::vec2(origin + glm::ivec2(x, z) * size);
+                glm::vec2 corner = glm::abs(pos - glm::vec2(center)) + glm::vec2(static_cast<float>(size));
+                if (glm::length(corner) < skipRadius) continue;
+
+                float h00 = static_cast<float>(m_heights[x + (z * samples)]);
+                float h10 = static_cast<float>(m_heights[(x + 1) + (z * samples)]);
+                float h01 = static_cast<float>(m_heights[x + ((z + 1) * samples)]);
+                float h11 = static_cast<float>(m_heights[(x + 1) + ((z + 1) * samples)]);
+
+                float dx = ((h10 - h00) + (h11 - h01)) / (2.0f * size);
+                float dz = ((h01 - h00) + (h11 - h10)) / (2.0f * size);
+                glm::vec3 normal = glm::normalize(glm::vec3(-dx, 1, -dz));
+
+                //steep slopes are drawn as stone, everything else as grass
+                float layer = normal.y < 0.7f ? m_stoneLayer : m_grassLayer;
+                glm::vec4 normalLayer = glm::vec4(normal, layer);
+
+                float s = static_cast<float>(size);
+                FarVertex v00 = { glm::vec4(pos.x, h00, pos.y, 1), normalLayer };
+                FarVertex v10 = { glm::vec4(pos.x + s, h10, pos.y, 1), normalLayer };
+                FarVertex v01 = { glm::vec4(pos.x, h01, pos.y + s, 1), normalLayer };
+                FarVertex v11 = { glm::vec4(pos.x + s, h11, pos.y + s, 1), normalLayer };
+
+                //same winding as the top face of a block
+                vertices.push_back(v00);
+                vertices.push_back(v10);
+                vertices.push_back(v01);
+                vertices.push_back(v10);
+                vertices.push_back(v11);
+                vertices.push_back(v01);
+            }
+        }
+    }
+}
+
+glm::ivec2 FarTerrain::getCenter() const {
+    glm::vec3 position = m_cameraSystem->camera().position();
+    glm::ivec2 pos = glm::ivec2(glm::floor(glm::vec2(position.x, position.z)));
+
+    return {
+        Chunk::divide(pos.x, cellSize * 2)[0] * cellSize * 2,
+        Chunk::divide(pos.y, cellSize * 2)[0] * cellSize * 2
+    };
+}
+
+glm::vec2 FarTerrain::getChunkCenter() const {
+    glm::vec3 position = m_cameraSystem->camera().position();
+    glm::ivec3 worldChunk = Chunk::worldToWorldChunk(glm::ivec3(glm::floor(position)));
+
+    return (glm::vec2(worldChunk.x, worldChunk.z) + glm::vec2(0.5f)) * static_cast<float>(Chunk::chunkSize);
+}
+
+float FarTerrain::innerRadius() const {
+    //every column closer than this is loaded by ChunkManager
+    return static_cast<float>((m_chunkManager->viewDistance() - 1) * Chunk::chunkSize);
+}
+
+void FarTerrain::createVertexBuffers() {
+    vk::BufferCreateInfo info = {};
+    info.size = m_maxVertexCount * sizeof(FarVertex);
+    info.usage = vk::BufferUsageFlags::VertexBuffer | vk::BufferUsageFlags::TransferDst;
+    info.sharingMode = vk::SharingMode::Exclusive;
+
+    VmaAllocationCreateInfo allocInfo = {};
+    allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    allocInfo.preferredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+
+    for (auto& buffer : m_vertexBuffers) {
+        buffer = std::make_unique<VoxelEngine::Buffer>(*m_engine, info, allocInfo);
+    }
+}
+
+void FarTerrain::createPipelineLayout() {
+    vk::PipelineLayoutCreateInfo info = {};
+    info.setLayouts = {
+        m_cameraSystem->descriptorLayout(),
+        m_textureManager->descriptorSetLayout()
+    };
+    info.pushConstantRanges = {
+        {
+            vk::ShaderStageFlags::Fragment,
+            0,
+            sizeof(glm::vec4)
+        }
+    };
+
+    m_pipelineLayout = std::make_unique<vk::PipelineLayout>(m_engine->getGraphics().device(), info);
+}
+
+void FarTerrain::createPipeline(vk::RenderPass& renderPass) {
+    std::vector<char> vertShaderCode = VoxelEngine::readFile("shaders/far.vert.spv");
+    std::vector<char> fragShaderCode = VoxelEngine::readFile("shaders/far.frag.spv");
+
+    vk::ShaderModule vertShader = VoxelEngine::createShaderModule(m_engine->getGraphics().device(), vertShaderCode);
+    vk::ShaderModule fragShader = VoxelEngine::createShaderModule(m_engine->getGraphics().device(), fragShaderCode);
+
+    vk::PipelineShaderStageCreateInfo vertInfo = {};
+    vertInfo.module = &vertShader;
+    vertInfo.name = "main";
+    vertInfo.stage = vk::ShaderStageFlags::Vertex;
+
+    vk::PipelineShaderStageCreateInfo fragInfo = {};
+    fragInfo.module = &fragShader;
+    fragInfo.name = "main";
+    fragInfo.stage = vk::ShaderStageFlags::Fragment;
+
+    std::vector<vk::PipelineShaderStageCreateInfo> stages = { std::move(vertInfo), std::move(fragInfo) };
+
+    vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {};
+    vertexInputInfo.vertexBindingDescriptions = {
+        {
+            0, sizeof(FarVertex)
+        }
+    };
+    vertexInputInfo.vertexAttributeDescriptions = {
+        {
+            0, 0, vk::Format::R32G32B32A32_Sfloat, offsetof(FarVertex, position)
+        },
+        {
+            1, 0, vk::Format::R32G32B32A32_Sfloat, offsetof(FarVertex, normal)
+        },
+    };
+
+    vk::PipelineInputAssemblyStateCreateInfo inputAssemblyInfo = {};
+    inputAssemblyInfo.topology = vk::PrimitiveTopology::TriangleList;
+
+    vk::PipelineViewportStateCreateInfo viewportInfo = {};
+    viewportInfo.viewports = { {} };    //still need 1 viewport and scissor here, even though they are dynamic
+    viewportInfo.scissors = { {} };
+
+    vk::PipelineRasterizationStateCreateInfo rasterizerInfo = {};
+    rasterizerInfo.polygonMode = vk::PolygonMode::Fill;
+    rasterizerInfo.lineWidth = 1.0f;
+    rasterizerInfo.cullMode = vk::CullModeFlags::Back;
+    rasterizerInfo.frontFace = vk::FrontFace::Clockwise;
+
+    vk::PipelineMultisampleStateCreateInfo multisampleInfo = {};
+    multisampleInfo.rasterizationSamples = vk::SampleCountFlags::_1;
+    multisampleInfo.minSampleShading = 1.0f;
+
+    vk::PipelineColorBlendAttachmentState colorBlendState = {};
+    colorBlendState.colorWriteMask =
+        vk::ColorComponentFlags::R
+        | vk::ColorComponentFlags::G
+        | vk::ColorComponentFlags::B
+        | vk::ColorComponentFlags::A;
+
+    vk::PipelineColorBlendStateCreateInfo colorBlendInfo = {};
+    colorBlendInfo.attachments = { colorBlendState };
+
+    vk::PipelineDepthStencilStateCreateInfo depthInfo = {};
+    depthInfo.depthTestEnable = true;
+    depthInfo.depthWriteEnable = true;
+    depthInfo.depthCompareOp = vk::CompareOp::Greater;
+
+    vk::PipelineDynamicStateCreateInfo dynamicInfo = {};
+    dynamicInfo.dynamicStates = { vk::DynamicState::Viewport, vk::DynamicState::Scissor };
+
+    vk::GraphicsPipelineCreateInfo info = {};
+    info.stages = stages;
+    info.vertexInputState = &vertexInputInfo;
+    info.inputAssemblyState = &inputAssemblyInfo;
+    info.viewportState = &viewportInfo;
+    info.rasterizationState = &rasterizerInfo;
+    info.multisampleState = &multisampleInfo;
+    info.colorBlendState = &colorBlendInfo;
+    info.depthStencilState = &depthInfo;
+    info.dynamicState = &dynamicInfo;
+    info.layout = m_pipelineLayout.get();
+    info.renderPass = &renderPass;
+    info.subpass = 0;
+
+    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_engine->getGraphics().device(), info, &m_engine->getGraphics().pipelineCache());
+}
\ No newline at end of file
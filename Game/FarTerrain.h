@@ -0,0 +1,84 @@
+#pragma once
+#include <VulkanWrapper/VulkanWrapper.h>
+#include <Engine/Engine.h>
+#include <Engine/System.h>
+#include <Engine/BlockingQueue.h>
+#include <Engine/BufferedQueue.h>
+#include <Engine/RenderGraph/TransferNode.h>
+#include <Engine/CameraSystem.h>
+#include <thread>
+
+class TerrainGenerator;
+class TextureManager;
+class ChunkManager;
+
+struct FarVertex {
+    glm::vec4 position;
+    glm::vec4 normal;       //w = texture layer
+};
+
+struct FarTerrainResults {
+    glm::ivec2 center;
+    std::vector<FarVertex> vertices;
+};
+
+//heightmap of the terrain outside of the loaded chunks, built from the base noise as nested rings (clipmap)
+class FarTerrain : public VoxelEngine::System {
+public:
+    static const int32_t levelCount = 4;
+    static const int32_t gridSize = 64;
+    static const int32_t cellSize = 16;
+
+    FarTerrain(VoxelEngine::Engine& engine, VoxelEngine::CameraSystem& cameraSystem, TerrainGenerator& terrainGenerator, TextureManager& textureManager, ChunkManager& chunkManager);
+
+    VoxelEngine::Buffer& vertexBuffer() const { return *m_vertexBuffers[m_bufferIndex]; }
+
+    void setTransferNode(VoxelEngine::TransferNode& transferNode);
+    void createPipeline(vk::RenderPass& renderPass);
+
+    std::thread& thread() { return m_thread; }
+
+    void run();
+    void stop();
+
+    void update(VoxelEngine::Clock& clock);
+    void draw(vk::CommandBuffer& commandBuffer, vk::Viewport viewport, vk::Rect2D scissor);
+
+private:
+    VoxelEngine::Engine* m_engine;
+    VoxelEngine::CameraSystem* m_cameraSystem;
+    VoxelEngine::TransferNode* m_transferNode;
+    TerrainGenerator* m_terrainGenerator;
+    TextureManager* m_textureManager;
+    ChunkManager* m_chunkManager;
+    float m_grassLayer;
+    float m_stoneLayer;
+
+    std::atomic<bool> m_running = false;
+    std::thread m_thread;
+    VoxelEngine::BlockingQueue<glm::ivec2> m_requestQueue;
+    VoxelEngine::BufferedQueue<FarTerrainResults> m_resultQueue;
+    std::vector<int32_t> m_heights;
+
+    std::array<std::unique_ptr<VoxelEngine::Buffer>, 2> m_vertexBuffers;
+    size_t m_bufferIndex = 0;
+    size_t m_vertexCount = 0;
+    size_t m_maxVertexCount;
+    uint32_t m_framesSinceSwap = 0;
+    FarTerrainResults m_pending;
+    bool m_hasPending = false;
+    glm::ivec2 m_center;
+    bool m_centerValid = false;
+
+    std::unique_ptr<vk::PipelineLayout> m_pipelineLayout;
+    std::unique_ptr<vk::Pipeline> m_pipeline;
+
+    void createVertexBuffers();
+    void createPipelineLayout();
+
+    void loop();
+    void generate(glm::ivec2 center, std::vector<FarVertex>& vertices);
+    glm::ivec2 getCenter() const;
+    glm::vec2 getChunkCenter() const;
+    float innerRadius() const;
+};
\ No newline at end of file
@@ -9,6 +9,10 @@ FrameRateCounter::FrameRateCounter(VoxelEngine::Window& window, std::string titl
     m_timer = 0;
 }
 
+void FrameRateCounter::setRenderGraph(VoxelEngine::RenderGraph& renderGraph) {
+    m_renderGraph = &renderGraph;
+}
+
 void FrameRateCounter::update(VoxelEngine::Clock& clock) {
     m_timer += clock.delta();
     m_frameCount++;
@@ -17,6 +21,16 @@ void FrameRateCounter::update(VoxelEngine::Clock& clock) {
         float frameRate = m_frameCount / m_timer;
         std::stringstream stream;
         stream << m_titlePrefix << " (" << std::fixed << std::setprecision(0) << frameRate << " fps)";
+
+        if (m_renderGraph != nullptr && m_renderGraph->timestampsEnabled()) {
+            float gpuTime = 0;
+
+            for (auto node : m_renderGraph->nodes()) {
+                gpuTime += node->gpuTime();
+            }
+
+            stream << " (" << std::setprecision(2) << gpuTime << " ms gpu)";
+        }
         m_window->setTitle(stream.str());
 
         m_timer = 0;
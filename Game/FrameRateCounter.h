@@ -2,15 +2,19 @@
 #include <Engine/System.h>
 #include <Engine/Window.h>
 #include <Engine/Clock.h>
+#include <Engine/RenderGraph/RenderGraph.h>
 
 class FrameRateCounter : public VoxelEngine::System {
 public:
     FrameRateCounter(VoxelEngine::Window& window, std::string titlePrefix);
 
+    void setRenderGraph(VoxelEngine::RenderGraph& renderGraph);
+
     void update(VoxelEngine::Clock& clock);
 
 private:
     VoxelEngine::Window* m_window;
+    VoxelEngine::RenderGraph* m_renderGraph = nullptr;
     std::string m_titlePrefix;
     size_t m_frameCount;
     float m_timer;
@@ -105,10 +105,22 @@ void FreeCam::update(VoxelEngine::Clock& clock) {
 
         if (raycastResult) {
             if (remove && !place) {
-                raycastResult->chunk->queueBlockUpdate({ World::airBlock(), Chunk::worldToChunk(raycastResult->blockPosition) });
+                auto lock = m_world->getLock();
+                Chunk* chunk = m_world->getChunk(raycastResult->worldChunkPosition);
+
+                if (chunk != nullptr) {
+                    chunk->queueBlockUpdate({ World::airBlock(), Chunk::worldToChunk(raycastResult->blockPosition) });
+                }
             } else if(!remove && place) {
                 Block block = Block(World::airBlock().type + 1 + m_placeType);
-                raycastResult->chunk->queueBlockUpdate({ block, Chunk::worldToChunk(raycastResult->blockPosition + raycastResult->normal) });
+                glm::ivec3 placePosition = raycastResult->blockPosition + raycastResult->normal;
+
+                auto lock = m_world->getLock();
+                Chunk* chunk = m_world->getChunk(Chunk::worldToWorldChunk(placePosition));
+
+                if (chunk != nullptr) {
+                    chunk->queueBlockUpdate({ block, Chunk::worldToChunk(placePosition) });
+                }
             }
         }
     }
@@ -1,6 +1,7 @@
 #include "MeshManager.h"
+#include <algorithm>
 
-const size_t pageSize = 256 * 1024 * 1024;
+const size_t maxPageSize = 256 * 1024 * 1024;
 
 MeshAllocation::MeshAllocation() {
     buffer = nullptr;
@@ -34,10 +35,10 @@ MeshAllocation::~MeshAllocation() {
     }
 }
 
-MeshManager::Page::Page(VoxelEngine::Engine& engine) : allocator(0, pageSize) {
+MeshManager::Page::Page(VoxelEngine::Engine& engine, size_t size) : allocator(0, size) {
     vk::BufferCreateInfo info = {};
-    info.size = pageSize;
-    info.usage = vk::BufferUsageFlags::VertexBuffer | vk::BufferUsageFlags::TransferDst;
+    info.size = size;
+    info.usage = vk::BufferUsageFlags::VertexBuffer | vk::BufferUsageFlags::StorageBuffer | vk::BufferUsageFlags::TransferDst;
     info.sharingMode = vk::SharingMode::Exclusive;
 
     VmaAllocationCreateInfo allocInfo = {};
@@ -50,6 +51,23 @@ MeshManager::Page::Page(VoxelEngine::Engine& engine) : allocator(0, pageSize) {
 
 MeshManager::MeshManager(VoxelEngine::Engine& engine) {
     m_engine = &engine;
+
+    //the whole page is bound as one storage buffer, so it can't be larger than the device allows (only 128 MB is guaranteed)
+    size_t maxRange = engine.getGraphics().device().physicalDevice().properties().limits.maxStorageBufferRange;
+    m_pageSize = std::min(maxPageSize, maxRange);
+
+    createDescriptorSetLayout();
+    createDescriptorPool();
+}
+
+const vk::DescriptorSet& MeshManager::descriptorSet(const VoxelEngine::Buffer& buffer) const {
+    for (auto& page : m_pages) {
+        if (page->buffer.get() == &buffer) {
+            return *page->descriptorSet;
+        }
+    }
+
+    throw std::runtime_error("Buffer is not a mesh page");
 }
 
 void MeshManager::setTransferNode(VoxelEngine::TransferNode& transferNode) {
@@ -100,8 +118,10 @@ MeshAllocation MeshManager::allocateBuffer(size_t size, size_t alignment) {
     }
 
     //create new page
-    {
-        auto& page = m_pages.emplace_back(std::make_unique<Page>(*m_engine));
+    if (m_pages.size() < maxPages) {
+        auto& page = m_pages.emplace_back(std::make_unique<Page>(*m_engine, m_pageSize));
+        createDescriptorSet(*page);
+
         VoxelEngine::Allocation allocation = page->allocator.allocate(size, alignment);
 
         if (allocation.allocator != nullptr) {
@@ -111,4 +131,44 @@ MeshAllocation MeshManager::allocateBuffer(size_t size, size_t alignment) {
 
     //allocation failed
     return {};
+}
+
+void MeshManager::createDescriptorSetLayout() {
+    vk::DescriptorSetLayoutBinding binding = {};
+    binding.binding = 0;
+    binding.descriptorType = vk::DescriptorType::StorageBuffer;
+    binding.descriptorCount = 1;
+    binding.stageFlags = vk::ShaderStageFlags::Vertex;
+
+    vk::DescriptorSetLayoutCreateInfo info = {};
+    info.bindings = { binding };
+
+    m_descriptorSetLayout = std::make_unique<vk::DescriptorSetLayout>(m_engine->getGraphics().device(), info);
+}
+
+void MeshManager::createDescriptorPool() {
+    vk::DescriptorPoolCreateInfo info = {};
+    info.maxSets = maxPages;
+    info.poolSizes = { { vk::DescriptorType::StorageBuffer, maxPages } };
+
+    m_descriptorPool = std::make_unique<vk::DescriptorPool>(m_engine->getGraphics().device(), info);
+}
+
+void MeshManager::createDescriptorSet(Page& page) {
+    vk::DescriptorSetAllocateInfo info = {};
+    info.descriptorPool = m_descriptorPool.get();
+    info.setLayouts = { *m_descriptorSetLayout };
+
+    page.descriptorSet = std::make_unique<vk::DescriptorSet>(std::move(m_descriptorPool->allocate(info)[0]));
+
+    vk::DescriptorBufferInfo bufferInfo = {};
+    bufferInfo.buffer = &page.buffer->buffer();
+    bufferInfo.range = m_pageSize;
+
+    vk::WriteDescriptorSet write = {};
+    write.dstSet = page.descriptorSet.get();
+    write.bufferInfo = { bufferInfo };
+    write.descriptorType = vk::DescriptorType::StorageBuffer;
+
+    vk::DescriptorSet::update(m_engine->getGraphics().device(), { write }, nullptr);
 }
\ No newline at end of file
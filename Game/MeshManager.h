@@ -20,14 +20,19 @@ class MeshManager {
     struct Page {
         VoxelEngine::FreeListAllocator allocator;
         std::shared_ptr<VoxelEngine::Buffer> buffer;
+        std::unique_ptr<vk::DescriptorSet> descriptorSet;
 
-        Page(VoxelEngine::Engine& engine);
+        Page(VoxelEngine::Engine& engine, size_t size);
     };
 
 public:
+    static const uint32_t maxPages = 64;
+
     MeshManager(VoxelEngine::Engine& engine);
 
     std::shared_ptr<VoxelEngine::Buffer>& indexBuffer() { return m_indexBuffer; }
+    const vk::DescriptorSetLayout& descriptorSetLayout() const { return *m_descriptorSetLayout; }
+    const vk::DescriptorSet& descriptorSet(const VoxelEngine::Buffer& buffer) const;
 
     void setTransferNode(VoxelEngine::TransferNode& transferNode);
 
@@ -36,12 +41,18 @@ public:
 private:
     VoxelEngine::Engine* m_engine;
     VoxelEngine::TransferNode* m_transferNode;
+    size_t m_pageSize;
 
     std::vector<std::unique_ptr<Page>> m_pages;
+    std::unique_ptr<vk::DescriptorSetLayout> m_descriptorSetLayout;
+    std::unique_ptr<vk::DescriptorPool> m_descriptorPool;
 
     std::shared_ptr<VoxelEngine::Buffer> m_indexBuffer;
     uint32_t m_indexCount;
     size_t m_indexBufferSize;
 
     void createIndexBuffer(std::vector<uint32_t>& indexData);
+    void createDescriptorSetLayout();
+    void createDescriptorPool();
+    void createDescriptorSet(Page& page);
 };
\ No newline at end of file
@@ -3,6 +3,7 @@
 MipmapGenerator::MipmapGenerator(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& graph)
     : VoxelEngine::RenderGraph::Node(graph, *engine.getGraphics().graphicsQueue(), vk::PipelineStageFlags::Transfer)
 {
+    setName("MipmapGenerator");
     m_engine = &engine;
 
     m_inputImageUsage = std::make_unique<VoxelEngine::RenderGraph::ImageUsage>(*this, vk::ImageLayout::TransferSrcOptimal, vk::AccessFlags::TransferWrite, vk::PipelineStageFlags::Transfer);
@@ -5,19 +5,31 @@ PriorityQueue::PriorityQueue() {
     m_playerPos = { max, max, max };
 }
 
-void PriorityQueue::enqueue(glm::ivec3 pos) {
-    if (m_set.insert(pos).second) {
-        m_items.push_back({ pos, VoxelEngine::distance2(pos, m_playerPos) });
-        std::push_heap(m_items.begin(), m_items.end());
+int32_t PriorityQueue::bias(glm::ivec3 pos) const {
+    auto it = m_biases.find(pos);
+    if (it == m_biases.end()) return 0;
+    return it->second;
+}
+
+void PriorityQueue::enqueue(glm::ivec3 pos, int32_t bias) {
+    auto result = m_biases.insert({ pos, bias });
+
+    if (!result.second) {
+        if (bias >= result.first->second) return;
+
+        //the item already in the heap is left behind and skipped once its bias no longer matches
+        result.first->second = bias;
     }
+
+    m_items.push_back({ pos, VoxelEngine::distance2(pos, m_playerPos) + bias, bias });
+    std::push_heap(m_items.begin(), m_items.end());
 }
 
 glm::ivec3 PriorityQueue::peek() {
     while (true) {
         Item item = m_items.front();
 
-        auto it = m_set.find(item.pos);
-        if (it == m_set.end()) {
+        if (!current(item)) {
             std::pop_heap(m_items.begin(), m_items.end());
             m_items.pop_back();
         } else {
@@ -32,16 +44,15 @@ glm::ivec3 PriorityQueue::dequeue() {
         std::pop_heap(m_items.begin(), m_items.end());
         m_items.pop_back();
 
-        auto it = m_set.find(item.pos);
-        if (it != m_set.end()) {
-            m_set.erase(it);
+        if (current(item)) {
+            m_biases.erase(item.pos);
             return item.pos;
         }
     }
 }
 
 void PriorityQueue::remove(glm::ivec3 pos) {
-    m_set.erase(pos);
+    m_biases.erase(pos);
 }
 
 void PriorityQueue::update(glm::ivec3 pos) {
@@ -49,12 +60,16 @@ void PriorityQueue::update(glm::ivec3 pos) {
         m_playerPos = pos;
 
         for (auto& item : m_items) {
-            auto it = m_set.find(item.pos);
-            if (it != m_set.end()) {
-                item.priority = VoxelEngine::distance2(pos, item.pos);
+            if (current(item)) {
+                item.priority = VoxelEngine::distance2(pos, item.pos) + item.bias;
             }
         }
 
         std::make_heap(m_items.begin(), m_items.end());
     }
+}
+
+bool PriorityQueue::current(const Item& item) const {
+    auto it = m_biases.find(item.pos);
+    return it != m_biases.end() && it->second == item.bias;
 }
\ No newline at end of file
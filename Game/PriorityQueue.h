@@ -1,6 +1,6 @@
 #pragma once
 #include <vector>
-#include <unordered_set>
+#include <unordered_map>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 #include <Engine/math.h>
@@ -12,9 +12,12 @@ class PriorityQueue {
 public:
     PriorityQueue();
 
-    size_t count() const { return m_set.size(); }
+    size_t count() const { return m_biases.size(); }
+    bool contains(glm::ivec3 pos) const { return m_biases.count(pos) > 0; }
+    int32_t bias(glm::ivec3 pos) const;
 
-    void enqueue(glm::ivec3 pos);
+    //enqueueing a position that is already queued keeps the lower of the two biases
+    void enqueue(glm::ivec3 pos, int32_t bias = 0);
     glm::ivec3 peek();
     glm::ivec3 dequeue();
     void remove(glm::ivec3 pos);
@@ -24,6 +27,7 @@ private:
     struct Item {
         glm::ivec3 pos;
         int32_t priority;
+        int32_t bias;
 
         bool operator < (const Item& other) {
             return priority > other.priority;
@@ -31,6 +35,8 @@ private:
     };
 
     std::vector<Item> m_items;
-    std::unordered_set<glm::ivec3> m_set;
+    std::unordered_map<glm::ivec3, int32_t> m_biases;
+
+    bool current(const Item& item) const;
     glm::ivec3 m_playerPos;
 };
\ No newline at end of file
@@ -8,17 +8,19 @@
 #include <entt/signal/sigh.hpp>
 #include "Chunk.h"
 #include "ChunkRenderer.h"
+#include "ChunkCuller.h"
 #include "TextureManager.h"
 #include "MipmapGenerator.h"
 #include "SkyboxManager.h"
 #include "SelectionBox.h"
+#include "FarTerrain.h"
 #include "World.h"
 
 class MeshManager;
 
 class Renderer : public VoxelEngine::System {
 public:
-    Renderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& renderGraph, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, MeshManager& meshManager);
+    Renderer(VoxelEngine::Engine& engine, VoxelEngine::RenderGraph& renderGraph, VoxelEngine::CameraSystem& cameraSystem, World& world, TextureManager& textureManager, SkyboxManager& skyboxManager, SelectionBox& selectionBox, FarTerrain& farTerrain, MeshManager& meshManager);
 
     VoxelEngine::TransferNode& transferNode() const { return *m_transferNode; }
     MipmapGenerator& mipmapGenerator() const { return *m_mipmapGenerator; }
@@ -36,5 +38,6 @@ private:
     VoxelEngine::PresentNode* m_presentNode;
     VoxelEngine::TransferNode* m_transferNode;
     ChunkRenderer* m_chunkRenderer;
+    ChunkCuller* m_chunkCuller;
     MipmapGenerator* m_mipmapGenerator;
 };
\ No newline at end of file
@@ -307,5 +307,5 @@ void SelectionBox::createPipeline(vk::RenderPass& renderPass) {
     info.renderPass = &renderPass;
     info.subpass = 0;
 
-    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_engine->getGraphics().device(), info);
+    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_engine->getGraphics().device(), info, &m_engine->getGraphics().pipelineCache());
 }
\ No newline at end of file
@@ -243,5 +243,5 @@ void SkyboxManager::createPipeline(vk::RenderPass& renderPass) {
     info.renderPass = &renderPass;
     info.subpass = 0;
 
-    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_engine->getGraphics().device(), info);
+    m_pipeline = std::make_unique<vk::GraphicsPipeline>(m_engine->getGraphics().device(), info, &m_engine->getGraphics().pipelineCache());
 }
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "TerrainGenerator.h"
+#include <Engine/Profiler.h>
 #include "World.h"
 #include "ChunkManager.h"
 #include "Chunk.h"
@@ -8,6 +9,10 @@ TerrainGenerator::TerrainGenerator(World& world, ChunkManager& chunkManager) : m
     m_world = &world;
     m_chunkManager = &chunkManager;
 
+    m_generateWaitHistogram = &VoxelEngine::Metrics::histogram("generate.wait");
+    m_generateServiceHistogram = &VoxelEngine::Metrics::histogram("generate.service");
+    m_generateCompletedCounter = &VoxelEngine::Metrics::counter("generate.completed");
+
     m_baseNoise.SetSeed(0);
     m_baseNoise.SetFrequency(0.005f);
 
@@ -33,16 +38,39 @@ void TerrainGenerator::stop() {
 }
 
 bool TerrainGenerator::enqueue(glm::ivec2 coord) {
-    return m_queue.tryEnqueue(coord);
+    return m_queue.tryEnqueue({ coord, VoxelEngine::Metrics::now() });
+}
+
+size_t TerrainGenerator::enqueueBulk(const std::vector<glm::ivec2>& coords) {
+    uint64_t time = VoxelEngine::Metrics::now();
+    m_bulkRequests.clear();
+
+    for (auto coord : coords) {
+        m_bulkRequests.push_back({ coord, time });
+    }
+
+    return m_queue.tryEnqueueBulk(m_bulkRequests.data(), m_bulkRequests.size());
 }
 
 void TerrainGenerator::loop() {
+    VOXEL_PROFILE_THREAD("TerrainGenerator");
+
+    std::vector<Request> requests;
+
     while (m_running) {
-        glm::ivec2 coord;
-        bool valid = m_queue.dequeue(coord);
-        if (!valid) return;
+        //claim several nearby columns at once, the queue is ordered by distance to the camera
+        requests.clear();
+        if (!m_queue.dequeueUpTo(requests, batchSize)) return;
+
+        for (auto& request : requests) {
+            uint64_t start = VoxelEngine::Metrics::now();
+            m_generateWaitHistogram->record(start - request.time);
+
+            generate(request.coord);
 
-        generate(coord);
+            m_generateServiceHistogram->record(VoxelEngine::Metrics::now() - start);
+            m_generateCompletedCounter->add();
+        }
     }
 }
 
@@ -52,14 +80,19 @@ int32_t dirtDepth = 3;
 int32_t caveAttenuationDepth = 10;
 float caveAttenuation = 0.75f;
 
+int32_t TerrainGenerator::getHeight(int32_t x, int32_t z) const {
+    return static_cast<int32_t>(round(m_baseNoise.GetSimplexFractal(static_cast<float>(x), static_cast<float>(z)) * amplitude + seaLevel));
+}
+
 void TerrainGenerator::generate(glm::ivec2 coord) {
+    VOXEL_PROFILE_SCOPE("TerrainGenerator::generate");
     std::array<std::array<int32_t, Chunk::chunkSize>, Chunk::chunkSize> values;
     std::array<ChunkData<bool, Chunk::chunkSize>, World::worldHeight> caveValues;
 
     for (int32_t x = 0; x < Chunk::chunkSize; x++) {
         for (int32_t y = 0; y < Chunk::chunkSize; y++) {
-            glm::vec2 pos = coord * Chunk::chunkSize + glm::ivec2(x, y);
-            values[x][y] = static_cast<int32_t>(round(m_baseNoise.GetSimplexFractal(pos.x, pos.y) * amplitude + seaLevel));
+            glm::ivec2 pos = coord * Chunk::chunkSize + glm::ivec2(x, y);
+            values[x][y] = getHeight(pos.x, pos.y);
         }
     }
 
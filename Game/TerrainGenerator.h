@@ -1,5 +1,6 @@
 #pragma once
 #include <Engine/BlockingQueue.h>
+#include <Engine/Metrics.h>
 #include <Engine/math.h>
 #include <thread>
 #include <FastNoise.h>
@@ -17,18 +18,38 @@ class TerrainGenerator {
 public:
     TerrainGenerator(World& world, ChunkManager& chunkManager);
 
+    std::thread& thread() { return m_thread; }
+
     void run();
     void stop();
 
     bool enqueue(glm::ivec2 coord);
+    size_t enqueueBulk(const std::vector<glm::ivec2>& coords);
+    size_t pendingCount() const { return m_queue.size(); }
+    size_t freeCount() const { return queueSize - m_queue.size(); }
+
+    //height of the ground from the base noise only, safe to call from any thread
+    int32_t getHeight(int32_t x, int32_t z) const;
 
 private:
+    struct Request {
+        glm::ivec2 coord;
+        uint64_t time;
+    };
+
     static const size_t queueSize = 16;
-    VoxelEngine::BlockingQueue<glm::ivec2> m_queue;
+    static const size_t batchSize = 4;
+    VoxelEngine::BlockingQueue<Request> m_queue;
+    std::vector<Request> m_bulkRequests;
     World* m_world;
     ChunkManager* m_chunkManager;
-    bool m_running = false;
+    std::atomic<bool> m_running = false;
     std::thread m_thread;
+
+    VoxelEngine::Histogram* m_generateWaitHistogram;
+    VoxelEngine::Histogram* m_generateServiceHistogram;
+    VoxelEngine::Counter* m_generateCompletedCounter;
+
     FastNoise m_baseNoise;
     FastNoise m_caveNoise1;
     FastNoise m_caveNoise2;
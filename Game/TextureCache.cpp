@@ -0,0 +1,359 @@
+#include "TextureCache.h"
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cstdio>
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t textureSize;
+    uint32_t mipLevels;
+    uint32_t count;
+};
+
+const uint32_t cacheMagic = 0x43544856;    //"VHTC"
+const uint32_t cacheVersion = 1;
+const size_t blockSize = 8;
+
+TextureCache::TextureCache(uint32_t textureSize, uint32_t mipLevels) {
+    m_textureSize = textureSize;
+    m_mipLevels = mipLevels;
+    m_bakedSize = 0;
+    m_dirty = false;
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        uint32_t size = std::max(textureSize >> i, 1u);
+        uint32_t blocks = (size + 3) / 4;
+
+        m_levelOffsets.push_back(m_bakedSize);
+        m_bakedSize += blocks * blocks * blockSize;
+    }
+}
+
+uint64_t TextureCache::hash(const void* data, size_t size) {
+    //FNV-1a
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    uint64_t result = 14695981039346656037ull;
+
+    for (size_t i = 0; i < size; i++) {
+        result ^= bytes[i];
+        result *= 1099511628211ull;
+    }
+
+    return result;
+}
+
+void TextureCache::bake(const uint8_t* pixels, std::vector<uint8_t>& data) const {
+    data.resize(m_bakedSize);
+
+    std::vector<uint8_t> level(pixels, pixels + (m_textureSize * m_textureSize * 4));
+    std::vector<uint8_t> next;
+    uint32_t size = m_textureSize;
+
+    for (uint32_t i = 0; i < m_mipLevels; i++) {
+        uint8_t* block = &data[m_levelOffsets[i]];
+
+        for (uint32_t by = 0; by < size; by += 4) {
+            for (uint32_t bx = 0; bx < size; bx += 4) {
+                //levels smaller than a block repeat their edge texels
+                uint8_t texels[64];
+
+                for (uint32_t y = 0; y < 4; y++) {
+                    for (uint32_t x = 0; x < 4; x++) {
+                        uint32_t sx = std::min(bx + x, size - 1);
+                        uint32_t sy = std::min(by + y, size - 1);
+                        memcpy(&texels[(y * 4 + x) * 4], &level[(sy * size + sx) * 4], 4);
+                    }
+                }
+
+                compressBlock(texels, block);
+                block += blockSize;
+            }
+        }
+
+        if (size == 1) {
+            continue;
+        }
+
+        uint32_t nextSize = size / 2;
+        next.resize(nextSize * nextSize * 4);
+
+        for (uint32_t y = 0; y < nextSize; y++) {
+            for (uint32_t x = 0; x < nextSize; x++) {
+                for (uint32_t c = 0; c < 4; c++) {
+                    uint32_t sum = level[((y * 2) * size + (x * 2)) * 4 + c]
+                        + level[((y * 2) * size + (x * 2 + 1)) * 4 + c]
+                        + level[((y * 2 + 1) * size + (x * 2)) * 4 + c]
+                        + level[((y * 2 + 1) * size + (x * 2 + 1)) * 4 + c];
+                    next[(y * nextSize + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+
+        level.swap(next);
+        size = nextSize;
+    }
+}
+
+static uint16_t packColor(const int32_t* color) {
+    int32_t r = (color[0] * 31 + 127) / 255;
+    int32_t g = (color[1] * 63 + 127) / 255;
+    int32_t b = (color[2] * 31 + 127) / 255;
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+static void unpackColor(uint16_t packed, int32_t* color) {
+    int32_t r = (packed >> 11) & 31;
+    int32_t g = (packed >> 5) & 63;
+    int32_t b = packed & 31;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void TextureCache::compressBlock(const uint8_t* pixels, uint8_t* block) {
+    //endpoints are the corners of the bounding box of the colors, on the diagonal that follows the colors' correlation
+    int32_t min[3] = { 255, 255, 255 };
+    int32_t max[3] = { 0, 0, 0 };
+    int32_t mean[3] = { 0, 0, 0 };
+    uint32_t opaqueCount = 0;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        const uint8_t* pixel = &pixels[i * 4];
+        if (pixel[3] < 128) continue;
+        opaqueCount++;
+
+        for (uint32_t c = 0; c < 3; c++) {
+            min[c] = std::min<int32_t>(min[c], pixel[c]);
+            max[c] = std::max<int32_t>(max[c], pixel[c]);
+            mean[c] += pixel[c];
+        }
+    }
+
+    if (opaqueCount == 0) {
+        //color0 <= color1 selects 3 color mode, where index 3 is transparent
+        memset(block, 0, 4);
+        memset(block + 4, 0xFF, 4);
+        return;
+    }
+
+    for (uint32_t c = 0; c < 3; c++) {
+        mean[c] /= static_cast<int32_t>(opaqueCount);
+    }
+
+    int32_t covarianceG = 0;
+    int32_t covarianceB = 0;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        const uint8_t* pixel = &pixels[i * 4];
+        if (pixel[3] < 128) continue;
+
+        int32_t r = pixel[0] - mean[0];
+        covarianceG += r * (pixel[1] - mean[1]);
+        covarianceB += r * (pixel[2] - mean[2]);
+    }
+
+    if (covarianceG < 0) std::swap(min[1], max[1]);
+    if (covarianceB < 0) std::swap(min[2], max[2]);
+
+    //move the endpoints inwards, so that they aren't pulled out by the 4 bit interpolation error
+    for (uint32_t c = 0; c < 3; c++) {
+        int32_t inset = (max[c] - min[c]) / 16;
+        min[c] = std::clamp(min[c] + inset, 0, 255);
+        max[c] = std::clamp(max[c] - inset, 0, 255);
+    }
+
+    uint16_t color0 = packColor(max);
+    uint16_t color1 = packColor(min);
+    bool transparent = opaqueCount < 16;
+
+    //4 color mode needs color0 > color1, 3 color mode needs color0 <= color1
+    if ((color0 < color1) != transparent && color0 != color1) {
+        std::swap(color0, color1);
+    }
+
+    int32_t palette[4][3];
+    unpackColor(color0, palette[0]);
+    unpackColor(color1, palette[1]);
+
+    uint32_t paletteSize;
+
+    if (transparent) {
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+        }
+
+        paletteSize = 3;
+    } else {
+        for (uint32_t c = 0; c < 3; c++) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        //equal endpoints select 3 color mode, where index 3 would be transparent, so only index 0 is used
+        paletteSize = color0 == color1 ? 1 : 4;
+    }
+
+    uint32_t indices = 0;
+
+    for (uint32_t i = 0; i < 16; i++) {
+        const uint8_t* pixel = &pixels[i * 4];
+        uint32_t index = 3;
+
+        if (pixel[3] >= 128) {
+            int32_t bestDistance = INT32_MAX;
+
+            for (uint32_t j = 0; j < paletteSize; j++) {
+                int32_t dr = pixel[0] - palette[j][0];
+                int32_t dg = pixel[1] - palette[j][1];
+                int32_t db = pixel[2] - palette[j][2];
+                int32_t distance = dr * dr + dg * dg + db * db;
+
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    index = j;
+                }
+            }
+        }
+
+        indices |= index << (i * 2);
+    }
+
+    memcpy(block, &color0, 2);
+    memcpy(block + 2, &color1, 2);
+    memcpy(block + 4, &indices, 4);
+}
+
+bool TextureCache::load(const std::string& fileName) {
+    m_entries.clear();
+    if (!m_file.open(fileName)) return false;
+
+    const uint8_t* ptr = m_file.data();
+    const uint8_t* end = ptr + m_file.size();
+
+    CacheHeader header;
+    if (m_file.size() < sizeof(CacheHeader)) {
+        m_file.close();
+        return false;
+    }
+
+    memcpy(&header, ptr, sizeof(CacheHeader));
+    ptr += sizeof(CacheHeader);
+
+    if (header.magic != cacheMagic || header.version != cacheVersion || header.textureSize != m_textureSize || header.mipLevels != m_mipLevels) {
+        m_file.close();
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.count; i++) {
+        uint32_t nameLength;
+        if (static_cast<size_t>(end - ptr) < sizeof(uint32_t)) break;
+        memcpy(&nameLength, ptr, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+
+        if (static_cast<size_t>(end - ptr) < nameLength + sizeof(uint64_t) + m_bakedSize) break;
+        std::string name(reinterpret_cast<const char*>(ptr), nameLength);
+        ptr += nameLength;
+
+        Entry entry;
+        memcpy(&entry.hash, ptr, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+
+        entry.data = ptr;
+        ptr += m_bakedSize;
+
+        m_entries[name] = entry;
+    }
+
+    return true;
+}
+
+void TextureCache::save(const std::string& fileName) {
+    //the mapped entries are copied out first, since the file is replaced
+    std::vector<char> data(sizeof(CacheHeader));
+    uint32_t count = 0;
+
+    auto write = [&](const std::string& name, uint64_t hash, const uint8_t* baked) {
+        uint32_t nameLength = static_cast<uint32_t>(name.size());
+        size_t offset = data.size();
+        data.resize(offset + sizeof(uint32_t) + nameLength + sizeof(uint64_t) + m_bakedSize);
+
+        char* ptr = &data[offset];
+        memcpy(ptr, &nameLength, sizeof(uint32_t));
+        ptr += sizeof(uint32_t);
+        memcpy(ptr, name.data(), nameLength);
+        ptr += nameLength;
+        memcpy(ptr, &hash, sizeof(uint64_t));
+        ptr += sizeof(uint64_t);
+        memcpy(ptr, baked, m_bakedSize);
+
+        count++;
+    };
+
+    for (auto& pair : m_entries) {
+        if (m_baked.count(pair.first) > 0) continue;
+        write(pair.first, pair.second.hash, pair.second.data);
+    }
+
+    for (auto& pair : m_baked) {
+        uint64_t hash;
+        memcpy(&hash, &pair.second[m_bakedSize], sizeof(uint64_t));
+        write(pair.first, hash, pair.second.data());
+    }
+
+    CacheHeader header = {};
+    header.magic = cacheMagic;
+    header.version = cacheVersion;
+    header.textureSize = m_textureSize;
+    header.mipLevels = m_mipLevels;
+    header.count = count;
+    memcpy(data.data(), &header, sizeof(CacheHeader));
+
+    m_entries.clear();
+    m_baked.clear();
+    m_file.close();
+    m_dirty = false;
+
+    //write to a temporary file first so that a crash can't leave a truncated cache behind
+    std::string tempPath = fileName + ".tmp";
+    std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) return;
+
+    file.write(data.data(), data.size());
+    file.close();
+
+    if (!file) {
+        std::remove(tempPath.c_str());
+        return;
+    }
+
+    std::remove(fileName.c_str());
+    std::rename(tempPath.c_str(), fileName.c_str());
+}
+
+const uint8_t* TextureCache::find(const std::string& name, uint64_t hash) const {
+    auto bakedIt = m_baked.find(name);
+    if (bakedIt != m_baked.end()) {
+        uint64_t bakedHash;
+        memcpy(&bakedHash, &bakedIt->second[m_bakedSize], sizeof(uint64_t));
+        return bakedHash == hash ? bakedIt->second.data() : nullptr;
+    }
+
+    auto it = m_entries.find(name);
+    if (it != m_entries.end() && it->second.hash == hash) {
+        return it->second.data;
+    } else {
+        return nullptr;
+    }
+}
+
+void TextureCache::insert(const std::string& name, uint64_t hash, const std::vector<uint8_t>& data) {
+    //the hash is stored after the baked data
+    std::vector<uint8_t> entry(m_bakedSize + sizeof(uint64_t));
+    memcpy(entry.data(), data.data(), m_bakedSize);
+    memcpy(&entry[m_bakedSize], &hash, sizeof(uint64_t));
+
+    m_baked[name] = std::move(entry);
+    m_dirty = true;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <Engine/MappedFile.h>
+
+//block textures with their mip chains already built and compressed to BC1, kept in one file between runs
+//entries are keyed by file name and a hash of the source file, so a texture is only baked again when the source changes
+class TextureCache {
+public:
+    TextureCache(uint32_t textureSize, uint32_t mipLevels);
+
+    //size of one baked texture, every mip level in order
+    size_t bakedSize() const { return m_bakedSize; }
+    size_t levelOffset(uint32_t level) const { return m_levelOffsets[level]; }
+    bool dirty() const { return m_dirty; }
+
+    static uint64_t hash(const void* data, size_t size);
+
+    //pixels are RGBA8 and textureSize x textureSize, data is resized to bakedSize
+    void bake(const uint8_t* pixels, std::vector<uint8_t>& data) const;
+
+    bool load(const std::string& fileName);
+    void save(const std::string& fileName);
+
+    //returns nullptr if the texture isn't cached or the source has changed
+    const uint8_t* find(const std::string& name, uint64_t hash) const;
+    void insert(const std::string& name, uint64_t hash, const std::vector<uint8_t>& data);
+
+private:
+    struct Entry {
+        uint64_t hash;
+        const uint8_t* data;
+    };
+
+    uint32_t m_textureSize;
+    uint32_t m_mipLevels;
+    size_t m_bakedSize;
+    std::vector<size_t> m_levelOffsets;
+
+    VoxelEngine::MappedFile m_file;
+    std::unordered_map<std::string, Entry> m_entries;
+    std::unordered_map<std::string, std::vector<uint8_t>> m_baked;
+    bool m_dirty;
+
+    static void compressBlock(const uint8_t* pixels, uint8_t* block);
+};
\ No newline at end of file
@@ -1,86 +1,286 @@
 #include "TextureManager.h"
 #include <stb_image.h>
+#include <iostream>
+#include <fstream>
+#include <algorithm>
 
-std::vector<std::string> textureNames = {
-    "resources/dirt.png",
-    "resources/grass_side.png",
-    "resources/grass_top.png",
-    "resources/stone.png",
-};
+const std::string cachePath = "texture_cache.bin";
 
-const uint32_t textureSize = 16;
-const uint32_t mipLevels = 5;
-
-TextureManager::TextureManager(VoxelEngine::Engine& engine) {
+TextureManager::TextureManager(VoxelEngine::Engine& engine) : m_requestQueue(queueSize), m_cache(textureSize, mipLevels) {
     m_engine = &engine;
+    m_transferNode = nullptr;
+    m_mipmapGenerator = nullptr;
+    m_layerCount = 0;
+    m_uploadedCount = 0;
+
+    //the mip chain of a compressed texture is baked with it, so the mipmap generator is only used for uncompressed textures
+    m_compressed = engine.getGraphics().enabledFeatures().features.textureCompressionBC;
+    std::vector<uint8_t> grey(textureSize * textureSize * 4, 128);
+
+    if (m_compressed) {
+        m_format = vk::Format::BC1_RGBA_Unorm_Block;
+        m_layerSize = m_cache.bakedSize();
+        m_cache.bake(grey.data(), m_placeholder);
+        m_cache.load(cachePath);
+    } else {
+        m_format = vk::Format::R8G8B8A8_Unorm;
+        m_layerSize = grey.size();
+        m_placeholder = std::move(grey);
+    }
 
-    createImage();
-    createImageView();
     createSampler();
     createDescriptorSetLayout();
-    createDescriptorPool();
-    createDescriptorSet();
-    writeDescriptorSet();
+    m_array = createArray(initialCapacity);
 }
 
 uint32_t TextureManager::count() const {
-    return static_cast<uint32_t>(textureNames.size());
+    return m_array.capacity;
 }
 
 uint32_t TextureManager::mipLevelCount() const {
     return mipLevels;
 }
 
+uint32_t TextureManager::registerTexture(const std::string& fileName) {
+    auto it = m_layers.find(fileName);
+    if (it != m_layers.end()) return it->second;
+
+    uint32_t layer = m_layerCount;
+    m_layerCount++;
+    m_layers.insert({ fileName, layer });
+
+    //mid grey until the file is decoded
+    m_layerData.insert(m_layerData.end(), m_placeholder.begin(), m_placeholder.end());
+    m_requestRequeue.push({ layer, fileName });
+
+    return layer;
+}
+
+uint32_t TextureManager::findTexture(const std::string& fileName) const {
+    auto it = m_layers.find(fileName);
+    if (it != m_layers.end()) {
+        return it->second;
+    } else {
+        return 0;
+    }
+}
+
 void TextureManager::createTexture(VoxelEngine::TransferNode& transferNode, MipmapGenerator& mipmapGenerator) {
-    for (uint32_t i = 0; i < textureNames.size(); i++) {
-        auto& fileName = textureNames[i];
-        int width;
-        int height;
-        int channels;
+    m_transferNode = &transferNode;
+    m_mipmapGenerator = &mipmapGenerator;
+}
+
+void TextureManager::run() {
+    m_running = true;
+    m_thread = std::thread([this] { loop(); });
+}
+
+void TextureManager::stop() {
+    m_running = false;
+    m_requestQueue.cancel();
+    m_thread.join();
+
+    if (m_cache.dirty()) {
+        m_cache.save(cachePath);
+    }
+}
+
+void TextureManager::update(VoxelEngine::Clock& clock) {
+    auto& renderGraph = m_engine->renderGraph();
+
+    //an old array can still be bound by a frame in flight
+    while (m_retiredArrays.size() > 0 && renderGraph.frameCount() >= m_retiredArrays.front().frame + renderGraph.framesInFlight()) {
+        m_retiredArrays.erase(m_retiredArrays.begin());
+    }
+
+    while (m_requestRequeue.size() > 0) {
+        if (!m_requestQueue.tryEnqueue(m_requestRequeue.front())) break;
+        m_requestRequeue.pop();
+    }
+
+    if (m_transferNode == nullptr) return;
+
+    bool changed = false;
+
+    if (m_layerCount > m_array.capacity) {
+        uint32_t capacity = m_array.capacity;
+
+        while (capacity < m_layerCount) {
+            capacity *= 2;
+        }
+
+        resize(capacity);
+        changed = true;
+    }
+
+    for (; m_uploadedCount < m_layerCount; m_uploadedCount++) {
+        uploadLayer(m_uploadedCount);
+        changed = true;
+    }
+
+    auto& results = m_resultQueue.swapDequeue();
+
+    while (results.size() > 0) {
+        auto& result = results.front();
+        memcpy(&m_layerData[result.layer * m_layerSize], result.data.data(), m_layerSize);
+        uploadLayer(result.layer);
+        changed = true;
+        results.pop();
+    }
+
+    if (changed && !m_compressed) {
+        m_mipmapGenerator->generate(m_array.image);
+    }
+}
 
-        auto data = stbi_load(fileName.c_str(), &width, &height, &channels, 4);
+void TextureManager::uploadLayer(uint32_t layer) {
+    vk::ImageSubresourceLayers subresource = {};
+    subresource.aspectMask = vk::ImageAspectFlags::Color;
+    subresource.baseArrayLayer = layer;
+    subresource.layerCount = 1;
+    subresource.mipLevel = 0;
 
-        vk::ImageSubresourceLayers subresource = {};
-        subresource.aspectMask = vk::ImageAspectFlags::Color;
-        subresource.baseArrayLayer = i;
-        subresource.layerCount = 1;
-        subresource.mipLevel = 0;
+    const uint8_t* data = &m_layerData[layer * m_layerSize];
 
-        transferNode.transfer(*m_image, {}, { textureSize, textureSize, 1 }, subresource, data);
+    if (!m_compressed) {
+        m_transferNode->transfer(*m_array.image, {}, { textureSize, textureSize, 1 }, subresource, data);
+        return;
+    }
+
+    for (uint32_t i = 0; i < mipLevels; i++) {
+        uint32_t size = std::max(textureSize >> i, 1u);
+        subresource.mipLevel = i;
+
+        m_transferNode->transfer(*m_array.image, {}, { size, size, 1 }, subresource, data + m_cache.levelOffset(i));
+    }
+}
+
+void TextureManager::resize(uint32_t capacity) {
+    uint32_t maxLayers = m_engine->getGraphics().device().physicalDevice().properties().limits.maxImageArrayLayers;
+
+    if (capacity > maxLayers) {
+        throw std::runtime_error("Too many block textures");
+    }
+
+    //the new array is filled from the CPU copy of every layer, so nothing needs to be copied between images
+    m_retiredArrays.push_back({ m_engine->renderGraph().frameCount(), std::move(m_array) });
+    m_array = createArray(capacity);
+    m_uploadedCount = 0;
+}
+
+void TextureManager::loop() {
+    while (m_running) {
+        DecodeRequest request;
+        if (!m_requestQueue.dequeue(request)) return;
+
+        decode(request);
+    }
+}
+
+void TextureManager::decode(DecodeRequest& request) {
+    std::string path = "resources/" + request.fileName;
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+    if (!file.is_open()) {
+        std::cout << "Failed to load texture " << path << std::endl;
+        return;
+    }
+
+    std::vector<uint8_t> source(static_cast<size_t>(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(source.data()), source.size());
+    file.close();
 
+    DecodeResult result = {};
+    result.layer = request.layer;
+
+    uint64_t hash = TextureCache::hash(source.data(), source.size());
+
+    if (m_compressed) {
+        const uint8_t* cached = m_cache.find(request.fileName, hash);
+
+        if (cached != nullptr) {
+            result.data.assign(cached, cached + m_layerSize);
+            m_resultQueue.enqueue(std::move(result));
+            return;
+        }
+    }
+
+    int width;
+    int height;
+    int channels;
+
+    auto data = stbi_load_from_memory(source.data(), static_cast<int>(source.size()), &width, &height, &channels, 4);
+
+    if (data == nullptr) {
+        std::cout << "Failed to load texture " << path << std::endl;
+        return;
+    }
+
+    if (width != textureSize || height != textureSize) {
+        std::cout << "Texture " << path << " must be " << textureSize << "x" << textureSize << std::endl;
         stbi_image_free(data);
+        return;
     }
 
-    mipmapGenerator.generate(m_image);
+    if (m_compressed) {
+        m_cache.bake(data, result.data);
+        m_cache.insert(request.fileName, hash, result.data);
+    } else {
+        result.data.assign(data, data + m_layerSize);
+    }
+
+    stbi_image_free(data);
+
+    m_resultQueue.enqueue(std::move(result));
 }
 
-void TextureManager::createImage() {
+TextureManager::TextureArray TextureManager::createArray(uint32_t capacity) {
+    TextureArray array = {};
+    array.capacity = capacity;
+
+    createImage(array);
+    createImageView(array);
+    createDescriptorPool(array);
+    createDescriptorSet(array);
+    writeDescriptorSet(array);
+
+    return array;
+}
+
+void TextureManager::createImage(TextureArray& array) {
     vk::ImageCreateInfo info = {};
-    info.usage = vk::ImageUsageFlags::TransferSrc | vk::ImageUsageFlags::TransferDst | vk::ImageUsageFlags::Sampled;
-    info.format = vk::Format::R8G8B8A8_Unorm;
-    info.arrayLayers = static_cast<uint32_t>(textureNames.size());
+    info.format = m_format;
+    info.arrayLayers = array.capacity;
     info.extent = { textureSize, textureSize, 1 };
     info.imageType = vk::ImageType::_2D;
     info.mipLevels = mipLevels;
     info.samples = vk::SampleCountFlags::_1;
 
+    //the mipmap generator blits from the previous level
+    if (m_compressed) {
+        info.usage = vk::ImageUsageFlags::TransferDst | vk::ImageUsageFlags::Sampled;
+    } else {
+        info.usage = vk::ImageUsageFlags::TransferSrc | vk::ImageUsageFlags::TransferDst | vk::ImageUsageFlags::Sampled;
+    }
+
     VmaAllocationCreateInfo allocInfo = {};
     allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
     allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
 
-    m_image = std::make_shared<VoxelEngine::Image>(*m_engine, info, allocInfo);
+    array.image = std::make_shared<VoxelEngine::Image>(*m_engine, info, allocInfo);
 }
 
-void TextureManager::createImageView() {
+void TextureManager::createImageView(TextureArray& array) {
     vk::ImageViewCreateInfo info = {};
-    info.image = &m_image->image();
-    info.format = vk::Format::R8G8B8A8_Unorm;
+    info.image = &array.image->image();
+    info.format = m_format;
     info.viewType = vk::ImageViewType::_2D_Array;
     info.subresourceRange.aspectMask = vk::ImageAspectFlags::Color;
-    info.subresourceRange.layerCount = static_cast<uint32_t>(textureNames.size());
+    info.subresourceRange.layerCount = array.capacity;
     info.subresourceRange.levelCount = mipLevels;
 
-    m_imageView = std::make_unique<vk::ImageView>(m_engine->getGraphics().device(), info);
+    array.imageView = std::make_unique<vk::ImageView>(m_engine->getGraphics().device(), info);
 }
 
 void TextureManager::createSampler() {
@@ -120,7 +320,7 @@ void TextureManager::createDescriptorSetLayout() {
     m_descriptorSetLayout = std::make_unique<vk::DescriptorSetLayout>(m_engine->getGraphics().device(), info);
 }
 
-void TextureManager::createDescriptorPool() {
+void TextureManager::createDescriptorPool(TextureArray& array) {
     vk::DescriptorPoolCreateInfo info = {};
     info.maxSets = 1;
     info.poolSizes = {
@@ -128,36 +328,36 @@ void TextureManager::createDescriptorPool() {
         { vk::DescriptorType::SampledImage, 1 }
     };
 
-    m_descriptorPool = std::make_unique<vk::DescriptorPool>(m_engine->getGraphics().device(), info);
+    array.descriptorPool = std::make_unique<vk::DescriptorPool>(m_engine->getGraphics().device(), info);
 }
 
-void TextureManager::createDescriptorSet() {
+void TextureManager::createDescriptorSet(TextureArray& array) {
     vk::DescriptorSetAllocateInfo info = {};
-    info.descriptorPool = m_descriptorPool.get();
+    info.descriptorPool = array.descriptorPool.get();
     info.setLayouts = { *m_descriptorSetLayout };
 
-    m_descriptorSet = std::make_unique<vk::DescriptorSet>(std::move(m_descriptorPool->allocate(info)[0]));
+    array.descriptorSet = std::make_unique<vk::DescriptorSet>(std::move(array.descriptorPool->allocate(info)[0]));
 }
 
-void TextureManager::writeDescriptorSet() {
+void TextureManager::writeDescriptorSet(TextureArray& array) {
     vk::DescriptorImageInfo imageInfo1 = {};
     imageInfo1.sampler = m_sampler.get();
 
     vk::DescriptorImageInfo imageInfo2 = {};
-    imageInfo2.imageView = m_imageView.get();
+    imageInfo2.imageView = array.imageView.get();
     imageInfo2.imageLayout = vk::ImageLayout::ShaderReadOnlyOptimal;
 
     vk::WriteDescriptorSet write1 = {};
     write1.imageInfo = { imageInfo1 };
-    write1.dstSet = m_descriptorSet.get();
+    write1.dstSet = array.descriptorSet.get();
     write1.dstBinding = 0;
     write1.descriptorType = vk::DescriptorType::Sampler;
 
     vk::WriteDescriptorSet write2 = {};
     write2.imageInfo = { imageInfo2 };
-    write2.dstSet = m_descriptorSet.get();
+    write2.dstSet = array.descriptorSet.get();
     write2.dstBinding = 1;
     write2.descriptorType = vk::DescriptorType::SampledImage;
 
-    m_descriptorSet->update(m_engine->getGraphics().device(), { write1, write2 }, nullptr);
+    array.descriptorSet->update(m_engine->getGraphics().device(), { write1, write2 }, nullptr);
 }
\ No newline at end of file
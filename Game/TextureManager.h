@@ -1,35 +1,105 @@
 #pragma once
 #include <VulkanWrapper/VulkanWrapper.h>
 #include <Engine/Engine.h>
+#include <Engine/System.h>
+#include <Engine/BlockingQueue.h>
+#include <Engine/BufferedQueue.h>
 #include <Engine/RenderGraph/TransferNode.h>
+#include <unordered_map>
+#include <thread>
 #include "MipmapGenerator.h"
+#include "TextureCache.h"
 
-class TextureManager {
+//texture array of block faces, textures are registered by name at any time and decoded on a worker thread
+//when the device supports BC formats, the textures are loaded from the baked cache instead of being decoded
+class TextureManager : public VoxelEngine::System {
 public:
+    static const uint32_t textureSize = 16;
+    static const uint32_t mipLevels = 5;
+    static const uint32_t initialCapacity = 16;
+    static const size_t queueSize = 64;
+
     TextureManager(VoxelEngine::Engine& engine);
 
     const vk::DescriptorSetLayout& descriptorSetLayout() const { return *m_descriptorSetLayout; }
-    const vk::DescriptorSet& descriptorSet() const { return *m_descriptorSet; }
-    std::shared_ptr<VoxelEngine::Image> image() const { return m_image; }
+    const vk::DescriptorSet& descriptorSet() const { return *m_array.descriptorSet; }
+    std::shared_ptr<VoxelEngine::Image> image() const { return m_array.image; }
     uint32_t count() const;
     uint32_t mipLevelCount() const;
 
+    //returns the layer of the texture, the layer shows a placeholder until the file is decoded
+    uint32_t registerTexture(const std::string& fileName);
+    uint32_t findTexture(const std::string& fileName) const;
+
     void createTexture(VoxelEngine::TransferNode& transferNode, MipmapGenerator& mipmapGenerator);
 
+    std::thread& thread() { return m_thread; }
+
+    void run();
+    void stop();
+
+    void update(VoxelEngine::Clock& clock);
+
 private:
+    struct TextureArray {
+        uint32_t capacity;
+        std::shared_ptr<VoxelEngine::Image> image;
+        std::unique_ptr<vk::ImageView> imageView;
+        std::unique_ptr<vk::DescriptorPool> descriptorPool;
+        std::unique_ptr<vk::DescriptorSet> descriptorSet;
+    };
+
+    struct RetiredArray {
+        uint32_t frame;
+        TextureArray array;
+    };
+
+    struct DecodeRequest {
+        uint32_t layer;
+        std::string fileName;
+    };
+
+    struct DecodeResult {
+        uint32_t layer;
+        std::vector<uint8_t> data;
+    };
+
     VoxelEngine::Engine* m_engine;
-    std::shared_ptr<VoxelEngine::Image> m_image;
-    std::unique_ptr<vk::ImageView> m_imageView;
+    VoxelEngine::TransferNode* m_transferNode;
+    MipmapGenerator* m_mipmapGenerator;
     std::unique_ptr<vk::Sampler> m_sampler;
     std::unique_ptr<vk::DescriptorSetLayout> m_descriptorSetLayout;
-    std::unique_ptr<vk::DescriptorPool> m_descriptorPool;
-    std::unique_ptr<vk::DescriptorSet> m_descriptorSet;
+    TextureArray m_array;
+    std::vector<RetiredArray> m_retiredArrays;
+    bool m_compressed;
+    vk::Format m_format;
+    size_t m_layerSize;
+    std::vector<uint8_t> m_placeholder;
+
+    std::unordered_map<std::string, uint32_t> m_layers;
+    std::vector<uint8_t> m_layerData;
+    uint32_t m_layerCount;
+    uint32_t m_uploadedCount;
 
-    void createImage();
-    void createImageView();
+    std::atomic<bool> m_running = false;
+    std::thread m_thread;
+    VoxelEngine::BlockingQueue<DecodeRequest> m_requestQueue;
+    std::queue<DecodeRequest> m_requestRequeue;
+    VoxelEngine::BufferedQueue<DecodeResult> m_resultQueue;
+    TextureCache m_cache;
+
+    TextureArray createArray(uint32_t capacity);
+    void createImage(TextureArray& array);
+    void createImageView(TextureArray& array);
     void createSampler();
     void createDescriptorSetLayout();
-    void createDescriptorPool();
-    void createDescriptorSet();
-    void writeDescriptorSet();
+    void createDescriptorPool(TextureArray& array);
+    void createDescriptorSet(TextureArray& array);
+    void writeDescriptorSet(TextureArray& array);
+
+    void uploadLayer(uint32_t layer);
+    void resize(uint32_t capacity);
+
+    void loop();
+    void decode(DecodeRequest& request);
 };
\ No newline at end of file
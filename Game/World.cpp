@@ -7,6 +7,16 @@ Block World::m_airBlock = Block(1);
 
 World::World(BlockManager& blockManager) {
     m_blockManager = &blockManager;
+    m_snapshot = std::make_shared<const Snapshot>();
+}
+
+const World::Snapshot::Column* World::Snapshot::getColumn(glm::ivec2 coord) const {
+    auto it = m_columns.find(coord);
+    if (it != m_columns.end()) {
+        return it->second.get();
+    } else {
+        return nullptr;
+    }
 }
 
 std::unique_lock<std::mutex> World::getLock() {
@@ -37,6 +47,8 @@ void World::destroyChunk(glm::ivec3 worldChunkPos, entt::entity entity) {
     if (m_chunkMap.erase(worldChunkPos) == 1) {
         m_chunkSet.erase(entity);
         m_recycleQueue.push(entity);
+        setChunkMeshed(worldChunkPos, entity, false);
+        m_snapshotChanges[worldChunkPos] = nullptr;
     }
 }
 
@@ -90,13 +102,317 @@ Block& World::getBlock(glm::ivec3 worldPos) {
     }
 }
 
+void World::setChunkMeshed(glm::ivec3 worldChunkPos, entt::entity entity, bool meshed) {
+    if (worldChunkPos.y < 0 || worldChunkPos.y >= worldHeight) return;
+
+    glm::ivec2 coord = { worldChunkPos.x, worldChunkPos.z };
+    auto it = m_columnIds.find(coord);
+    uint32_t id;
+
+    if (it != m_columnIds.end()) {
+        id = it->second;
+    } else {
+        if (!meshed) return;
+
+        id = m_nextColumnId++;
+        m_columnIds.insert({ coord, id });
+
+        ColumnBounds column = {};
+        column.coord = coord;
+        column.chunks.fill(entt::null);
+        m_columns.insert({ id, column });
+
+        //the box covers the whole height, so it also bounds the chunks without a mesh that the traversal steps through
+        glm::vec3 origin = glm::vec3(coord.x, 0, coord.y) * static_cast<float>(Chunk::chunkSize);
+        glm::vec3 extent = glm::vec3(1, worldHeight, 1) * static_cast<float>(Chunk::chunkSize);
+        m_columnBounds.set(id, origin, extent);
+    }
+
+    ColumnBounds& column = m_columns[id];
+    column.chunks[worldChunkPos.y] = meshed ? entity : entt::null;
+
+    //the range of chunks that have a mesh
+    column.minChunk = -1;
+    column.maxChunk = -1;
+
+    for (int32_t i = 0; i < worldHeight; i++) {
+        if (column.chunks[i] == entt::null) continue;
+        if (column.minChunk < 0) column.minChunk = i;
+        column.maxChunk = i;
+    }
+
+    if (column.minChunk < 0) {
+        m_columnBounds.remove(id);
+        m_columns.erase(id);
+        m_columnIds.erase(coord);
+    }
+}
+
+void World::cullColumns(VoxelEngine::Frustum frustum) {
+    m_visibleColumns.clear();
+    m_columnBounds.cull(frustum, m_visibleColumns);
+
+    m_columnVisibility.clear();
+
+    for (auto& pair : m_columns) {
+        m_columnVisibility[pair.second.coord] = ColumnVisibility::Outside;
+    }
+
+    glm::vec3 extent = glm::vec3(1, worldHeight, 1) * static_cast<float>(Chunk::chunkSize);
+
+    for (auto id : m_visibleColumns) {
+        glm::ivec2 coord = m_columns[id].coord;
+        glm::vec3 origin = glm::vec3(coord.x, 0, coord.y) * static_cast<float>(Chunk::chunkSize);
+        bool contained = frustum.containsAABB(origin, extent);
+        m_columnVisibility[coord] = contained ? ColumnVisibility::Inside : ColumnVisibility::Intersecting;
+    }
+}
+
+ColumnVisibility World::columnVisibility(glm::ivec2 coord) const {
+    auto it = m_columnVisibility.find(coord);
+    if (it != m_columnVisibility.end()) {
+        return it->second;
+    } else {
+        return ColumnVisibility::Unknown;
+    }
+}
+
+void World::cullChunks(VoxelEngine::Frustum frustum, std::vector<entt::entity>& visible) {
+    for (auto id : m_visibleColumns) {
+        ColumnBounds& column = m_columns[id];
+        glm::vec3 origin = glm::vec3(column.coord.x, column.minChunk, column.coord.y) * static_cast<float>(Chunk::chunkSize);
+        glm::vec3 extent = glm::vec3(1, column.maxChunk - column.minChunk + 1, 1) * static_cast<float>(Chunk::chunkSize);
+        bool contained = frustum.containsAABB(origin, extent);
+
+        for (int32_t i = column.minChunk; i <= column.maxChunk; i++) {
+            entt::entity entity = column.chunks[i];
+            if (entity == entt::null) continue;
+
+            if (!contained) {
+                glm::vec3 chunkOrigin = glm::vec3(column.coord.x, i, column.coord.y) * static_cast<float>(Chunk::chunkSize);
+                if (!frustum.testAABB(chunkOrigin, glm::vec3(Chunk::chunkSize))) continue;
+            }
+
+            visible.push_back(entity);
+        }
+    }
+}
+
 void World::queueChunkUpdate(glm::ivec3 worldChunkPos) {
     m_worldUpdates.enqueue(worldChunkPos);
 }
 
-std::optional<RaycastResult> World::raycast(glm::vec3 origin, glm::vec3 dir, float distance) {
+void WorldEdit::setBlock(glm::ivec3 worldPos, Block block) {
+    fill(worldPos, worldPos, block);
+}
+
+void WorldEdit::fill(glm::ivec3 min, glm::ivec3 max, Block block) {
+    RegionUpdate update = {};
+    update.operation = RegionOperation::Fill;
+    update.block = block;
+
+    addRegion(update, min, max, min);
+}
+
+void WorldEdit::replace(glm::ivec3 min, glm::ivec3 max, Block from, Block to) {
+    RegionUpdate update = {};
+    update.operation = RegionOperation::Replace;
+    update.block = to;
+    update.from = from;
+
+    addRegion(update, min, max, min);
+}
+
+void WorldEdit::paste(const std::shared_ptr<const BlockRegion>& region, glm::ivec3 worldPos) {
+    RegionUpdate update = {};
+    update.operation = RegionOperation::Paste;
+    update.source = region;
+
+    addRegion(update, worldPos, worldPos + region->size - glm::ivec3(1, 1, 1), worldPos);
+}
+
+void WorldEdit::addRegion(const RegionUpdate& update, glm::ivec3 min, glm::ivec3 max, glm::ivec3 sourceOrigin) {
+    const int32_t maxHeight = static_cast<int32_t>(World::worldHeight) * Chunk::chunkSize - 1;
+    min.y = std::max(min.y, 0);
+    max.y = std::min(max.y, maxHeight);
+
+    if (min.x > max.x || min.y > max.y || min.z > max.z) return;
+
+    glm::ivec3 minChunk = Chunk::worldToWorldChunk(min);
+    glm::ivec3 maxChunk = Chunk::worldToWorldChunk(max);
+
+    for (int32_t x = minChunk.x; x <= maxChunk.x; x++) {
+        for (int32_t y = minChunk.y; y <= maxChunk.y; y++) {
+            for (int32_t z = minChunk.z; z <= maxChunk.z; z++) {
+                glm::ivec3 worldChunkPos = { x, y, z };
+                glm::ivec3 chunkOrigin = worldChunkPos * Chunk::chunkSize;
+
+                RegionUpdate chunkUpdate = update;
+                chunkUpdate.min = glm::max(min - chunkOrigin, glm::ivec3(0, 0, 0));
+                chunkUpdate.max = glm::min(max - chunkOrigin, glm::ivec3(Chunk::chunkSize - 1));
+                chunkUpdate.sourcePos = chunkOrigin + chunkUpdate.min - sourceOrigin;
+
+                m_updates[worldChunkPos].push_back(chunkUpdate);
+            }
+        }
+    }
+}
+
+bool World::commit(WorldEdit& edit) {
     auto lock = getLock();
+    uint64_t id = ++m_editCount;
+
+    for (auto it = edit.m_updates.begin(); it != edit.m_updates.end();) {
+        Chunk* chunk = getChunk(it->first);
+
+        if (chunk == nullptr) {
+            it++;
+            continue;
+        }
+
+        chunk->queueRegionUpdates(it->second);
+        chunk->setEditGeneration(id);
+        m_editUpdates.enqueue({ it->first, id });
+        it = edit.m_updates.erase(it);
+    }
+
+    return edit.empty();
+}
+
+bool World::fill(glm::ivec3 min, glm::ivec3 max, Block block) {
+    auto edit = beginEdit();
+    edit.fill(min, max, block);
+    return commit(edit);
+}
+
+bool World::replace(glm::ivec3 min, glm::ivec3 max, Block from, Block to) {
+    auto edit = beginEdit();
+    edit.replace(min, max, from, to);
+    return commit(edit);
+}
+
+bool World::paste(const std::shared_ptr<const BlockRegion>& region, glm::ivec3 worldPos) {
+    auto edit = beginEdit();
+    edit.paste(region, worldPos);
+    return commit(edit);
+}
+
+std::shared_ptr<BlockRegion> World::copy(glm::ivec3 min, glm::ivec3 max) const {
+    auto region = std::make_shared<BlockRegion>();
+    region->size = glm::max(max - min + glm::ivec3(1, 1, 1), glm::ivec3(0, 0, 0));
+    region->blocks.resize(static_cast<size_t>(region->size.x) * region->size.y * region->size.z, m_airBlock);
+
+    if (region->blocks.size() == 0) return region;
+
+    auto snapshot = this->snapshot();
+    glm::ivec3 minChunk = Chunk::worldToWorldChunk(min);
+    glm::ivec3 maxChunk = Chunk::worldToWorldChunk(max);
+
+    //whole rows are copied out of each chunk at once
+    for (int32_t x = minChunk.x; x <= maxChunk.x; x++) {
+        for (int32_t z = minChunk.z; z <= maxChunk.z; z++) {
+            auto column = snapshot->getColumn({ x, z });
+            if (column == nullptr) continue;
+
+            for (int32_t y = std::max(minChunk.y, 0); y <= std::min<int32_t>(maxChunk.y, worldHeight - 1); y++) {
+                auto blocks = (*column)[y].get();
+                if (blocks == nullptr) continue;
+
+                glm::ivec3 chunkOrigin = glm::ivec3(x, y, z) * Chunk::chunkSize;
+                glm::ivec3 chunkMin = glm::max(min - chunkOrigin, glm::ivec3(0, 0, 0));
+                glm::ivec3 chunkMax = glm::min(max - chunkOrigin, glm::ivec3(Chunk::chunkSize - 1));
+                size_t length = chunkMax.x - chunkMin.x + 1;
+
+                for (int32_t cz = chunkMin.z; cz <= chunkMax.z; cz++) {
+                    for (int32_t cy = chunkMin.y; cy <= chunkMax.y; cy++) {
+                        glm::ivec3 chunkPos = { chunkMin.x, cy, cz };
+                        const Block* src = &(*blocks)[chunkPos];
+                        Block* dst = &region->blocks[region->index(chunkOrigin + chunkPos - min)];
+                        memcpy(dst, src, length * sizeof(Block));
+                    }
+                }
+            }
+        }
+    }
+
+    return region;
+}
+
+void World::updateSnapshot(glm::ivec3 worldChunkPos) {
+    Chunk* chunk = getChunk(worldChunkPos);
+    if (chunk == nullptr) return;
+
+    std::shared_ptr<const Snapshot::Blocks> blocks;
+
+    //copy reads the snapshot too, so any block other than air has to be kept, not just solid ones
+    const Block* data = chunk->blocks().data();
+    const size_t blockCount = Chunk::chunkSize * Chunk::chunkSize * Chunk::chunkSize;
+
+    for (size_t i = 0; i < blockCount; i++) {
+        if (data[i].type != m_airBlock.type) {
+            blocks = std::make_shared<const Snapshot::Blocks>(chunk->blocks());
+            break;
+        }
+    }
 
+    m_snapshotChanges[worldChunkPos] = blocks;
+}
+
+void World::publishSnapshot() {
+    if (m_snapshotChanges.size() == 0) return;
+
+    //columns that did not change are shared with the previous snapshot
+    Snapshot::ColumnMap columns = m_snapshot->columns();
+
+    for (auto& pair : m_snapshotChanges) {
+        glm::ivec3 worldChunkPos = pair.first;
+        if (worldChunkPos.y < 0 || worldChunkPos.y >= worldHeight) continue;
+
+        glm::ivec2 coord = { worldChunkPos.x, worldChunkPos.z };
+        auto it = columns.find(coord);
+
+        Snapshot::Column column = {};
+        if (it != columns.end()) {
+            column = *it->second;
+        }
+
+        column[worldChunkPos.y] = pair.second;
+
+        bool empty = true;
+        for (auto& blocks : column) {
+            if (blocks != nullptr) {
+                empty = false;
+                break;
+            }
+        }
+
+        if (empty) {
+            columns.erase(coord);
+        } else {
+            columns[coord] = std::make_shared<const Snapshot::Column>(column);
+        }
+    }
+
+    m_snapshotChanges.clear();
+    std::atomic_store(&m_snapshot, std::shared_ptr<const Snapshot>(std::make_shared<Snapshot>(std::move(columns))));
+}
+
+std::optional<RaycastResult> World::raycast(glm::vec3 origin, glm::vec3 dir, float distance) const {
+    auto snapshot = this->snapshot();
+    return raycast(*snapshot, origin, dir, distance);
+}
+
+void World::raycastMany(const std::vector<RaycastQuery>& queries, std::vector<std::optional<RaycastResult>>& results) const {
+    auto snapshot = this->snapshot();
+    results.resize(queries.size());
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        auto& query = queries[i];
+        results[i] = raycast(*snapshot, query.origin, query.dir, query.distance);
+    }
+}
+
+std::optional<RaycastResult> World::raycast(const Snapshot& snapshot, glm::vec3 origin, glm::vec3 dir, float distance) const {
     float t = 0.0f;
 
     glm::ivec3 i = glm::ivec3(
@@ -126,8 +442,14 @@ std::optional<RaycastResult> World::raycast(glm::vec3 origin, glm::vec3 dir, flo
     glm::vec3 max = tDelta * dist;
     int32_t steppedIndex = -1;
 
-    auto view = m_registry.view<Chunk>();
-    Chunk* currentChunk = getChunk(chunkPos);
+    //the column is only looked up again when the ray leaves it
+    glm::ivec2 columnCoord = { chunkPos.x, chunkPos.z };
+    const Snapshot::Column* currentColumn = snapshot.getColumn(columnCoord);
+    const Snapshot::Blocks* currentBlocks = nullptr;
+
+    if (currentColumn != nullptr && chunkPos.y >= 0 && chunkPos.y < worldHeight) {
+        currentBlocks = (*currentColumn)[chunkPos.y].get();
+    }
 
     while (t <= distance) {
         if (!Chunk::chunkPosInBounds(pos)) {
@@ -136,20 +458,27 @@ std::optional<RaycastResult> World::raycast(glm::vec3 origin, glm::vec3 dir, flo
             chunkPos = worldPos[0];
             pos = worldPos[1];
 
-            currentChunk = getChunk(chunkPos);
+            if (chunkPos.x != columnCoord.x || chunkPos.z != columnCoord.y) {
+                columnCoord = { chunkPos.x, chunkPos.z };
+                currentColumn = snapshot.getColumn(columnCoord);
+            }
+
+            currentBlocks = nullptr;
+            if (currentColumn != nullptr && chunkPos.y >= 0 && chunkPos.y < worldHeight) {
+                currentBlocks = (*currentColumn)[chunkPos.y].get();
+            }
         }
 
-        if (currentChunk != nullptr) {
-            Block& block = currentChunk->blocks()[pos];
-            BlockType& type = m_blockManager->getType(block);
+        if (currentBlocks != nullptr) {
+            Block block = (*currentBlocks)[pos];
 
-            if (type.solid()) {
+            if (m_blockManager->solid(block)) {
                 RaycastResult result;
                 result.blockPosition = i;
                 result.position = origin + t * dir;
                 result.normal = {};
                 result.normal[steppedIndex] = -step[steppedIndex];
-                result.chunk = currentChunk;
+                result.worldChunkPosition = chunkPos;
 
                 return result;
             }
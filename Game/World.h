@@ -4,7 +4,9 @@
 #include <unordered_set>
 #include <Engine/math.h>
 #include <Engine/BufferedQueue.h>
+#include <Engine/BoundsList.h>
 #include <mutex>
+#include <memory>
 #include <optional>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
@@ -17,7 +19,46 @@ struct RaycastResult {
     glm::vec3 position;
     glm::ivec3 blockPosition;
     glm::ivec3 normal;
-    Chunk* chunk;
+    glm::ivec3 worldChunkPosition;
+};
+
+//block edits grouped by chunk, applied together by World::commit
+//edits are split into one box per chunk and applied in order by ChunkUpdater, min and max are inclusive
+class WorldEdit {
+    friend class World;
+
+public:
+    bool empty() const { return m_updates.size() == 0; }
+
+    void setBlock(glm::ivec3 worldPos, Block block);
+    void fill(glm::ivec3 min, glm::ivec3 max, Block block);
+    void replace(glm::ivec3 min, glm::ivec3 max, Block from, Block to);
+    void paste(const std::shared_ptr<const BlockRegion>& region, glm::ivec3 worldPos);
+
+private:
+    std::unordered_map<glm::ivec3, std::vector<RegionUpdate>> m_updates;
+
+    void addRegion(const RegionUpdate& update, glm::ivec3 min, glm::ivec3 max, glm::ivec3 sourceOrigin);
+};
+
+//a chunk changed by an edit, edit ids increase with every commit
+struct EditUpdate {
+    glm::ivec3 worldChunkPos;
+    uint64_t edit;
+};
+
+struct RaycastQuery {
+    glm::vec3 origin;
+    glm::vec3 dir;
+    float distance;
+};
+
+//how a column's full height box relates to the frustum, Unknown for columns without a meshed chunk
+enum class ColumnVisibility {
+    Unknown,
+    Outside,
+    Intersecting,
+    Inside
 };
 
 class World {
@@ -26,6 +67,23 @@ public:
     static const Block& nullBlock() { return m_nullBlock; }
     static const Block& airBlock() { return m_airBlock; }
 
+    //immutable copy of the loaded blocks, a snapshot stays valid for as long as a reader holds it
+    class Snapshot {
+    public:
+        using Blocks = ChunkData<Block, Chunk::chunkSize>;
+        using Column = std::array<std::shared_ptr<const Blocks>, worldHeight>;
+        using ColumnMap = std::unordered_map<glm::ivec2, std::shared_ptr<const Column>>;
+
+        Snapshot() {}
+        Snapshot(ColumnMap&& columns) : m_columns(std::move(columns)) {}
+
+        const ColumnMap& columns() const { return m_columns; }
+        const Column* getColumn(glm::ivec2 coord) const;
+
+    private:
+        ColumnMap m_columns;
+    };
+
     World(BlockManager& blockManager);
 
     std::unique_lock<std::mutex> getLock();
@@ -45,11 +103,46 @@ public:
 
     void queueChunkUpdate(glm::ivec3 worldChunkPos);
 
+    //tracks which chunks have a mesh, for culling
+    void setChunkMeshed(glm::ivec3 worldChunkPos, entt::entity entity, bool meshed);
+    //tests every column with a mesh against the frustum, must be called before cullChunks or columnVisibility each frame
+    void cullColumns(VoxelEngine::Frustum frustum);
+    ColumnVisibility columnVisibility(glm::ivec2 coord) const;
+    //chunks are only tested in columns that are partially inside the frustum
+    void cullChunks(VoxelEngine::Frustum frustum, std::vector<entt::entity>& visible);
+
     std::queue<glm::ivec3>& getChunkUpdates() { return m_worldUpdates.swapDequeue(); }
+    std::queue<EditUpdate>& getEditUpdates() { return m_editUpdates.swapDequeue(); }
+
+    WorldEdit beginEdit() { return WorldEdit(); }
+    //each edited chunk is updated once, and meshing waits until every chunk in the edit is updated
+    //updates for chunks that aren't loaded are left in edit, returns false if there were any
+    bool commit(WorldEdit& edit);
+
+    //return false if part of the edit fell on chunks that aren't loaded
+    bool fill(glm::ivec3 min, glm::ivec3 max, Block block);
+    bool replace(glm::ivec3 min, glm::ivec3 max, Block from, Block to);
+    bool paste(const std::shared_ptr<const BlockRegion>& region, glm::ivec3 worldPos);
+    //reads the latest snapshot, unloaded chunks are copied as air
+    std::shared_ptr<BlockRegion> copy(glm::ivec3 min, glm::ivec3 max) const;
 
-    std::optional<RaycastResult> raycast(glm::vec3 origin, glm::vec3 dir, float distance);
+    //copies the chunk's blocks into the next snapshot, chunks that are all air are left out
+    void updateSnapshot(glm::ivec3 worldChunkPos);
+    void publishSnapshot();
+    std::shared_ptr<const Snapshot> snapshot() const { return std::atomic_load(&m_snapshot); }
+
+    //raycasts read the latest snapshot and never take the world lock
+    std::optional<RaycastResult> raycast(glm::vec3 origin, glm::vec3 dir, float distance) const;
+    void raycastMany(const std::vector<RaycastQuery>& queries, std::vector<std::optional<RaycastResult>>& results) const;
 
 private:
+    struct ColumnBounds {
+        glm::ivec2 coord;
+        std::array<entt::entity, worldHeight> chunks;  //null if the chunk has no mesh
+        int32_t minChunk;
+        int32_t maxChunk;
+    };
+
     static Block m_nullBlock;
     static Block m_airBlock;
 
@@ -59,5 +152,17 @@ private:
     std::unordered_set<entt::entity> m_chunkSet;
     std::unordered_map<glm::ivec3, entt::entity> m_chunkMap;
     VoxelEngine::BufferedQueue<glm::ivec3> m_worldUpdates;
+    VoxelEngine::BufferedQueue<EditUpdate> m_editUpdates;
+    uint64_t m_editCount = 0;
     std::queue<entt::entity> m_recycleQueue;
+    std::unordered_map<glm::ivec2, uint32_t> m_columnIds;
+    std::unordered_map<uint32_t, ColumnBounds> m_columns;
+    uint32_t m_nextColumnId = 0;
+    VoxelEngine::BoundsList m_columnBounds;
+    std::vector<uint32_t> m_visibleColumns;
+    std::unordered_map<glm::ivec2, ColumnVisibility> m_columnVisibility;
+    std::shared_ptr<const Snapshot> m_snapshot;
+    std::unordered_map<glm::ivec3, std::shared_ptr<const Snapshot::Blocks>> m_snapshotChanges;
+
+    std::optional<RaycastResult> raycast(const Snapshot& snapshot, glm::vec3 origin, glm::vec3 dir, float distance) const;
 };
\ No newline at end of file
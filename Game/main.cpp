@@ -1,4 +1,11 @@
 #include <iostream>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <memory>
 #include <Engine/Engine.h>
 #include <Engine/RenderGraph/AcquireNode.h>
 #include <Engine/RenderGraph/PresentNode.h>
@@ -19,49 +26,116 @@
 #include "SkyboxManager.h"
 #include "SelectionBox.h"
 #include "MeshManager.h"
+#include "FarTerrain.h"
+
+struct Options {
+    float frameRate = 144.0f;   //0 runs uncapped
+    float tickRate = 0.0f;      //above 0 runs headless at this rate
+    float runTime = 0.0f;       //above 0 stops after this many seconds
+    bool depthPrepass = false;  //windowed only
+};
+
+static VoxelEngine::Engine* s_engine = nullptr;
+
+static void printUsage() {
+    std::cout << "Usage: Game [--fps <rate>] [--headless <tick rate>] [--run-for <seconds>] [--depth-prepass]" << std::endl;
+    std::cout << "  --fps            frame rate cap for the windowed loop, 0 for uncapped (default 144)" << std::endl;
+    std::cout << "  --headless       update the world at a fixed tick rate without a window or rendering, stop with Ctrl+C" << std::endl;
+    std::cout << "  --run-for        stop after the given number of seconds" << std::endl;
+    std::cout << "  --depth-prepass  draw the chunks' depth before shading them" << std::endl;
+}
+
+static bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--depth-prepass") {
+            options.depthPrepass = true;
+            continue;
+        }
+
+        if (i + 1 >= argc) return false;
+
+        float value;
+
+        try {
+            value = std::stof(argv[++i]);
+        } catch (const std::exception&) {
+            return false;
+        }
+
+        if (arg == "--fps" && value >= 0) {
+            options.frameRate = value;
+        } else if (arg == "--headless" && value > 0) {
+            options.tickRate = value;
+        } else if (arg == "--run-for" && value > 0) {
+            options.runTime = value;
+        } else {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    bool headless = options.tickRate > 0;
 
-int main() {
     VoxelEngine::Engine engine;
-    VoxelEngine::Window window(800, 600, "VoxelGame");
-    engine.addWindow(window);
+    engine.setTargetFrameRate(options.frameRate);
+
+    //a headless run has no window or swapchain, and leaves out every system that only exists to draw or take input
+    std::unique_ptr<VoxelEngine::Window> window;
 
     VoxelEngine::Graphics& graphics = engine.getGraphics();
-    graphics.setWindow(window);
+
+    if (!headless) {
+        window = std::make_unique<VoxelEngine::Window>(800, 600, "VoxelGame");
+        engine.addWindow(*window);
+        graphics.setWindow(*window);
+    }
+
     vk::PhysicalDeviceFeatures2 features = {};
     vk::PhysicalDeviceFeatures2 supportedFeatures = graphics.getSupportedFeatures();
 
     if (supportedFeatures.features.samplerAnisotropy) features.features.samplerAnisotropy = true;
     if (supportedFeatures.features12.timelineSemaphore) features.features12.timelineSemaphore = true;
+    if (supportedFeatures.features.multiDrawIndirect) features.features.multiDrawIndirect = true;
+    if (supportedFeatures.features.drawIndirectFirstInstance) features.features.drawIndirectFirstInstance = true;
+    if (supportedFeatures.features12.drawIndirectCount) features.features12.drawIndirectCount = true;
+    if (supportedFeatures.features.textureCompressionBC) features.features.textureCompressionBC = true;
 
     graphics.pickPhysicalDevice(&features);
 
+    //buffers and images are destroyed through the render graph, so a headless run still needs one, but never executes it
     VoxelEngine::RenderGraph renderGraph(graphics.device(), 2);
     engine.setRenderGraph(renderGraph);
 
-    FrameRateCounter counter(window, "VoxelGame");
-    engine.getUpdateGroup().add(counter, 0);
-
-    VoxelEngine::Camera camera(engine, window.getFramebufferWidth(), window.getFramebufferHeight(), glm::radians(90.0f), 0.01f, 1000.0f);
-    VoxelEngine::CameraSystem cameraSystem(engine);
-    cameraSystem.setCamera(camera);
-    engine.getUpdateGroup().add(cameraSystem, 90);
+    VoxelEngine::MetricsWriter metricsWriter("metrics.csv", 5.0f);
+    engine.getUpdateGroup().add(metricsWriter, 0, "MetricsWriter");
 
-    window.onFramebufferResized().connect<&VoxelEngine::Camera::setSize>(&camera);
+    uint32_t width = headless ? 800 : window->getFramebufferWidth();
+    uint32_t height = headless ? 600 : window->getFramebufferHeight();
+    VoxelEngine::Camera camera(engine, width, height, glm::radians(90.0f), 0.01f, 8192.0f);
+    camera.setPosition({ 0, 80, 0 });
 
     MeshManager meshManager(engine);
-    SkyboxManager skyboxManager(engine, cameraSystem);
-    SelectionBox selectionBox(engine, cameraSystem);
     TextureManager textureManager(engine);
     BlockManager blockManager;
+    blockManager.loadManifest("resources/blocks.txt", textureManager);
+    //the workers started below read the block tables without locking
+    blockManager.freeze();
     World world(blockManager);
 
-    FreeCam freeCam(camera, window.input(), world, blockManager, selectionBox);
-    engine.getUpdateGroup().add(freeCam, 10);
-
-    freeCam.setPosition({ 0, 80, 0 });
-
-    ChunkManager chunkManager(world, freeCam, 16);
-    engine.getUpdateGroup().add(chunkManager, 20);
+    ChunkManager chunkManager(world, camera, 32, { 8, 16, 24 });
+    engine.getUpdateGroup().add(chunkManager, 20, "ChunkManager");
 
     TerrainGenerator terrainGenerator(world, chunkManager);
     terrainGenerator.run();
@@ -70,32 +144,121 @@ int main() {
     chunkUpdater.run();
 
     ChunkMesher chunkMesher(engine, world, blockManager, meshManager);
-    engine.getUpdateGroup().add(chunkMesher, 30);
+    engine.getUpdateGroup().add(chunkMesher, 30, "ChunkMesher");
     chunkMesher.run();
 
     chunkManager.setTerrainGenerator(terrainGenerator);
     chunkManager.setChunkUpdater(chunkUpdater);
     chunkManager.setChunkMesher(chunkMesher);
 
-    Renderer renderer(engine, renderGraph, cameraSystem, world, textureManager, skyboxManager, selectionBox, meshManager);
-    engine.getUpdateGroup().add(renderer, 100);
+    engine.addWorkerThread(terrainGenerator.thread());
+    engine.addWorkerThread(chunkUpdater.thread());
+    engine.addWorkerThread(chunkMesher.thread());
 
-    meshManager.setTransferNode(renderer.transferNode());
-    cameraSystem.setTransferNode(renderer.transferNode());
-    chunkMesher.setTransferNode(renderer.transferNode());
-    textureManager.createTexture(renderer.transferNode(), renderer.mipmapGenerator());
-    skyboxManager.transfer(renderer.transferNode());
-    skyboxManager.createPipeline(renderer.chunkRenderer().renderPass());
-    selectionBox.transfer(renderer.transferNode());
-    selectionBox.createMesh(renderer.transferNode(), meshManager);
-    selectionBox.createPipeline(renderer.chunkRenderer().renderPass());
+    std::unique_ptr<FrameRateCounter> counter;
+    std::unique_ptr<VoxelEngine::CameraSystem> cameraSystem;
+    std::unique_ptr<SkyboxManager> skyboxManager;
+    std::unique_ptr<SelectionBox> selectionBox;
+    std::unique_ptr<FreeCam> freeCam;
+    std::unique_ptr<FarTerrain> farTerrain;
+    std::unique_ptr<Renderer> renderer;
 
-    engine.run();
+    if (!headless) {
+        renderGraph.enableTimestamps();
+        engine.setTraceKey(VoxelEngine::Key::F3, "trace.json");
+
+        counter = std::make_unique<FrameRateCounter>(*window, "VoxelGame");
+        counter->setRenderGraph(renderGraph);
+        engine.getUpdateGroup().add(*counter, 0, "FrameRateCounter");
+
+        cameraSystem = std::make_unique<VoxelEngine::CameraSystem>(engine);
+        cameraSystem->setCamera(camera);
+        engine.getUpdateGroup().add(*cameraSystem, 90, "CameraSystem");
+
+        window->onFramebufferResized().connect<&VoxelEngine::Camera::setSize>(&camera);
+
+        skyboxManager = std::make_unique<SkyboxManager>(engine, *cameraSystem);
+        selectionBox = std::make_unique<SelectionBox>(engine, *cameraSystem);
+
+        freeCam = std::make_unique<FreeCam>(camera, window->input(), world, blockManager, *selectionBox);
+        engine.getUpdateGroup().add(*freeCam, 10, "FreeCam");
+
+        freeCam->setPosition(camera.position());
+
+        farTerrain = std::make_unique<FarTerrain>(engine, *cameraSystem, terrainGenerator, textureManager, chunkManager);
+        engine.getUpdateGroup().add(*farTerrain, 40, "FarTerrain");
+        farTerrain->run();
+
+        engine.getUpdateGroup().add(textureManager, 95, "TextureManager");
+        textureManager.run();
+
+        renderer = std::make_unique<Renderer>(engine, renderGraph, *cameraSystem, world, textureManager, *skyboxManager, *selectionBox, *farTerrain, meshManager);
+        engine.getUpdateGroup().add(*renderer, 100, "Renderer");
+        renderer->chunkRenderer().setDepthPrepass(options.depthPrepass);
+
+        meshManager.setTransferNode(renderer->transferNode());
+        cameraSystem->setTransferNode(renderer->transferNode());
+        chunkMesher.setTransferNode(renderer->transferNode());
+        farTerrain->setTransferNode(renderer->transferNode());
+        textureManager.createTexture(renderer->transferNode(), renderer->mipmapGenerator());
+        skyboxManager->transfer(renderer->transferNode());
+        skyboxManager->createPipeline(renderer->chunkRenderer().renderPass());
+        selectionBox->transfer(renderer->transferNode());
+        selectionBox->createMesh(renderer->transferNode(), meshManager);
+        selectionBox->createPipeline(renderer->chunkRenderer().renderPass());
+        farTerrain->createPipeline(renderer->chunkRenderer().renderPass());
+
+        engine.addWorkerThread(farTerrain->thread());
+        engine.addWorkerThread(textureManager.thread());
+    }
+
+    //the engine loop can end before the time limit, so the timer waits on a condition variable it can be woken from
+    std::mutex timerMutex;
+    std::condition_variable timerCondition;
+    bool finished = false;
+    std::thread timer;
+
+    if (options.runTime > 0) {
+        timer = std::thread([&] {
+            std::unique_lock<std::mutex> lock(timerMutex);
+            if (!timerCondition.wait_for(lock, std::chrono::duration<float>(options.runTime), [&] { return finished; })) {
+                engine.stop();
+            }
+        });
+    }
+
+    if (headless) {
+        s_engine = &engine;
+        std::signal(SIGINT, [](int) { s_engine->stop(); });
+        engine.runHeadless(options.tickRate);
+    } else {
+        engine.run();
+    }
+
+    if (timer.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(timerMutex);
+            finished = true;
+        }
+
+        timerCondition.notify_one();
+        timer.join();
+    }
 
     terrainGenerator.stop();
     chunkUpdater.stop();
     chunkMesher.stop();
+
+    if (!headless) {
+        farTerrain->stop();
+        textureManager.stop();
+    }
+
     engine.getGraphics().device().waitIdle();
 
+    //the final summary goes next to metrics.csv instead of flooding the console
+    std::ofstream metricsFile("metrics.txt");
+    VoxelEngine::Metrics::writeText(metricsFile);
+
     return 0;
 }
\ No newline at end of file
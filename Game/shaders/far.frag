@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec3 fragUV;
+layout(location = 2) in vec2 fragWorld;
+
+layout(location = 0) out vec4 outColor;
+
+layout (set = 1, binding = 0) uniform sampler textureSampler;
+layout (set = 1, binding = 1) uniform texture2DArray textureArray;
+
+layout(push_constant) uniform Info {
+    vec4 center;    //xy = center of the camera's chunk, z = radius of the loaded chunks
+} info;
+
+void main() {
+    if (distance(fragWorld, info.center.xy) < info.center.z) discard;
+
+    //the smallest mip level is the average color of the texture
+    float level = float(textureQueryLevels(sampler2DArray(textureArray, textureSampler)) - 1);
+    outColor = vec4(fragColor * textureLod(sampler2DArray(textureArray, textureSampler), fragUV, level).xyz, 1.0);
+}
\ No newline at end of file
@@ -0,0 +1,23 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) in vec4 vPosition;
+layout(location = 1) in vec4 vNormal;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec3 fragUV;
+layout(location = 2) out vec2 fragWorld;
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+} ubo;
+
+void main() {
+    gl_Position = ubo.proj * ubo.view * vec4(vPosition.xyz, 1.0);
+
+    //slopes are darkened slightly so that the shape of the terrain is visible
+    fragColor = vec3(mix(0.75, 1.0, vNormal.y));
+    fragUV = vec3(0.5, 0.5, vNormal.w);
+    fragWorld = vPosition.xz;
+}
\ No newline at end of file
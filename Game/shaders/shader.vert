@@ -1,9 +1,8 @@
 #version 450
 #extension GL_ARB_separate_shader_objects : enable
 
-layout(location = 0) in ivec3 vPosition;
-layout(location = 1) in vec4 vColor;
-layout(location = 2) in ivec3 vUV;
+//the depth prepass and the shading pass must produce exactly the same depth
+invariant gl_Position;
 
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec3 fragUV;
@@ -13,12 +12,56 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 proj;
 } ubo;
 
-layout(push_constant) uniform Transform {
-	ivec4 pos;
-} transform;
+layout(set = 2, binding = 0) readonly buffer Transforms {
+    ivec4 transforms[];
+};
+
+//x = ChunkFace::data, y = ChunkFace::light
+layout(set = 3, binding = 0) readonly buffer Faces {
+    uvec2 faces[];
+};
+
+//matches Chunk::NeighborFaces
+const ivec3 faceVertices[24] = ivec3[](
+    ivec3(1, 1, 1), ivec3(1, 1, 0), ivec3(1, 0, 1), ivec3(1, 0, 0),
+    ivec3(0, 1, 0), ivec3(0, 1, 1), ivec3(0, 0, 0), ivec3(0, 0, 1),
+    ivec3(0, 1, 0), ivec3(1, 1, 0), ivec3(0, 1, 1), ivec3(1, 1, 1),
+    ivec3(1, 0, 0), ivec3(0, 0, 0), ivec3(1, 0, 1), ivec3(0, 0, 1),
+    ivec3(0, 1, 1), ivec3(1, 1, 1), ivec3(0, 0, 1), ivec3(1, 0, 1),
+    ivec3(1, 1, 0), ivec3(0, 1, 0), ivec3(1, 0, 0), ivec3(0, 0, 0)
+);
+
+//matches Chunk::uvFaces
+const vec2 uvFaces[4] = vec2[](
+    vec2(0, 0),
+    vec2(1, 0),
+    vec2(0, 1),
+    vec2(1, 1)
+);
+
+//two triangles per face, same winding as the old quad index buffer
+const uint corners[6] = uint[](0, 1, 2, 1, 3, 2);
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * vec4(vPosition + transform.pos.xyz, 1.0);
-    fragColor = vColor.xyz;
-    fragUV = vUV;
+    uvec2 face = faces[gl_VertexIndex / 6];
+    uint corner = corners[gl_VertexIndex % 6];
+
+    //see ChunkFace for the layout of each face
+    ivec3 position = ivec3(face.x & 31u, (face.x >> 5) & 31u, (face.x >> 10) & 31u);
+    uint direction = (face.x >> 15) & 7u;
+    int scale = 1 << ((face.x >> 18) & 3u);
+    uint layer = face.x >> 20;
+    uint sunLight = (face.y >> (corner * 4)) & 15u;
+    uint blockLight = (face.y >> (16u + corner * 4)) & 15u;
+
+    //firstInstance of each draw holds the index of its chunk transform
+    ivec4 transform = transforms[gl_InstanceIndex];
+    position += faceVertices[direction * 4 + corner] * scale;
+
+    gl_Position = ubo.proj * ubo.view * vec4(position + transform.xyz, 1.0);
+    //block light is tinted warm, whichever channel is brighter wins
+    vec3 sun = vec3(float(sunLight) / 15.0);
+    vec3 block = vec3(1.0, 0.85, 0.65) * (float(blockLight) / 15.0);
+    fragColor = max(sun, block);
+    fragUV = vec3(uvFaces[corner], float(layer));
 }
\ No newline at end of file
@@ -21,7 +21,8 @@ void main() {
         ubo.view[2].xyz
     ));
 
-    vec4 position = vec4(positions[gl_VertexIndex], 1.0, 1.0);
+    //depth is reversed, so the far plane is at 0
+    vec4 position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
     gl_Position = position;
     fragPosition = (inverse(ubo.proj * view) * position).xyz;
 }
\ No newline at end of file